@@ -4,8 +4,66 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define PAGE_SIZE (1 << 12)
-#define HUGE_PAGE_SIZE (1 << 14)
+#define HUGE_PAGE_SIZE (1 << 21)
+
+#if defined(ARENA_PREFAULT_THREAD) && !defined(ARENA_PREFAULT)
+#define ARENA_PREFAULT
+#endif
+
+#if defined(ARENA_CHUNK_POOL_GLOBAL) && !defined(ARENA_CHUNK_POOL)
+#define ARENA_CHUNK_POOL
+#endif
+
+/*
+  Alignment of every chunk data buffer. It matches the guarantee
+  given by malloc() on the common platforms, so the first allocation
+  of a chunk never needs padding.
+*/
+#define ARENA_CHUNK_ALIGNMENT (2 * sizeof(void*))
+
+#ifndef ARENA_DEFAULT_ALIGNMENT
+#define ARENA_DEFAULT_ALIGNMENT ARENA_CHUNK_ALIGNMENT
+#endif
+
+#ifndef ARENA_GROWTH_FACTOR
+#define ARENA_GROWTH_FACTOR 2
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define ARENA_ALIGNAS(alignment) _Alignas(alignment)
+#define ARENA_ALIGNOF(type) _Alignof(type)
+#elif defined(__GNUC__)
+#define ARENA_ALIGNAS(alignment) __attribute__((aligned(alignment)))
+#define ARENA_ALIGNOF(type) __alignof__(type)
+#else
+#define ARENA_ALIGNAS(alignment)
+#define ARENA_ALIGNOF(type) offsetof(struct { char c; type member; }, member)
+#endif
+
+/*
+  Typed allocations, `count` objects of type `type`.
+  ARENA_NEW returns NULL if the total size overflows, ARENA_NEW_BATCH 
+  is a statement that leaves `ptrs` untouched in that case. The typed 
+  pointers are stored as `type*`, never through a `void**` alias.
+*/
+#define ARENA_NEW(arena, type, count) \
+    ((type*)arena_alloc_array((arena), (count), sizeof(type), ARENA_ALIGNOF(type)))
+
+#define ARENA_NEW_BATCH(arena, type, ptrs, count)                                   \
+    do {                                                                            \
+        const size_t arena_batch_count_ = (count);                                  \
+        type* const arena_batch_ = ARENA_NEW((arena), type, arena_batch_count_);    \
+                                                                                    \
+        for(size_t arena_i_ = 0; arena_batch_ != NULL &&                            \
+                                 arena_i_ < arena_batch_count_; arena_i_++) {       \
+            (ptrs)[arena_i_] = arena_batch_ + arena_i_;                             \
+        }                                                                           \
+    } while(0)
 
 typedef struct _arena_chunk {
 
@@ -13,24 +71,241 @@ typedef struct _arena_chunk {
     
     size_t size;
     size_t used;
+    size_t capacity;
+    size_t dirty;
+
+#ifdef ARENA_REDUCE_FRAGMENTATION
+    struct _arena_chunk* bin_next;
+    struct _arena_chunk* bin_prev;
+    size_t bin;
+#endif
+
+#ifdef ARENA_SNAPSHOT
+    size_t image_offset;
+#endif
 
-    uint8_t data[];
+    ARENA_ALIGNAS(ARENA_CHUNK_ALIGNMENT) uint8_t data[];
 } arena_chunk_t;
 
+#define ARENA_CHUNK_POOL_BUCKETS_COUNT 64
+
+/*
+  The head of a pool bucket, its first chunk and a generation tag. 
+  Both are swapped together with a double-width compare-and-swap.
+*/
+typedef struct {
+    ARENA_ALIGNAS(2 * sizeof(void*)) arena_chunk_t* first;
+    uintptr_t tag;
+} arena_chunk_pool_bucket_t;
+
+/*
+  The free chunks of a pool are kept in buckets, the bucket `i` 
+  holds the chunks of [2^i, 2^(i + 1)) bytes. `size` is the sum 
+  of the sizes of the pooled chunks, it never exceeds `max_size`.
+  `poppers` counts the pops in progress, the chunks leaving the pool 
+  wait in `retired` until they can be freed.
+*/
+typedef struct {
+    arena_chunk_pool_bucket_t buckets[ARENA_CHUNK_POOL_BUCKETS_COUNT];
+    size_t chunk_size;
+
+    size_t size;
+    size_t max_size;
+
+    size_t poppers;
+    arena_chunk_t* retired;
+} arena_chunk_pool_t;
+
+/*
+  The counters of an arena. `requested`, `padding`, `wasted` and 
+  `malloc_calls` add up since the creation of the arena, the others 
+  describe its current state.
+*/
+typedef struct {
+    size_t requested;
+    size_t padding;
+    size_t wasted;
+
+    size_t used;
+    size_t peak_used;
+
+    size_t chunks_count;
+    size_t capacity;
+
+    size_t malloc_calls;
+} arena_stats_t;
+
+typedef struct {
+    void (*chunk_acquired)(void* user_data, const arena_chunk_t* chunk);
+    void (*chunk_released)(void* user_data, const arena_chunk_t* chunk);
+
+    void* user_data;
+} arena_hooks_t;
+
 typedef struct {
+    arena_chunk_t* chunk;
+    arena_chunk_t* last;
+    size_t used;
+    size_t redzones_count;
+} arena_mark_t;
+
+/*
+  A child arena carves its chunks out of its parent, `parent_mark` 
+  is the state of the parent before the first chunk was carved and 
+  `parent_used` the used space of the parent after the last one.
+  `children_mark` and `children_used` are the same for all the 
+  children of the arena, since the first live one was created.
+*/
+typedef struct _arena {
     arena_chunk_t* begin;
     arena_chunk_t* end;
+
+    size_t alignment;
+
+    size_t chunk_size;
+    size_t max_chunk_size;
+
+    size_t max_retained_size;
+
+    arena_chunk_pool_t* chunk_pool;
+    arena_chunk_t* buffer;
+
+    struct _arena* parent;
+    arena_mark_t parent_mark;
+    size_t parent_used;
+    size_t children_count;
+    arena_mark_t children_mark;
+    size_t children_used;
+
+    struct _arena_free_index* free_index;
+    struct _arena_redzones* redzones;
+
+    arena_chunk_t* spare;
+    struct _arena_prefaulter* prefaulter;
+
+    arena_stats_t stats;
+    const arena_hooks_t* hooks;
+
+    struct _arena_directory* directory;
+
+#ifdef ARENA_SNAPSHOT
+    size_t image_size;
+#endif
 } arena_t;
 
+typedef struct {
+    arena_t* arena;
+
+    void* data;
+    size_t length;
+    size_t capacity;
+
+    size_t element_size;
+} arena_vec_t;
+
+typedef struct {
+    arena_t* arena;
+
+    char* data;
+    size_t length;
+    size_t capacity;
+} arena_strbuf_t;
+
+typedef struct {
+    const void* key;
+    size_t key_length;
+    void* value;
+} arena_map_entry_t;
+
+typedef struct {
+    arena_t* arena;
+
+    uint64_t* hashes;
+    arena_map_entry_t* entries;
+
+    size_t count;
+    size_t capacity;
+} arena_map_t;
+
+typedef struct {
+    arena_map_t map;
+    arena_vec_t strings;
+} arena_interner_t;
+
+#define ARENA_POOL_CLASSES_COUNT 9
+#define ARENA_POOL_MIN_SIZE ARENA_CHUNK_ALIGNMENT
+#define ARENA_POOL_MAX_SIZE (ARENA_POOL_MIN_SIZE << (ARENA_POOL_CLASSES_COUNT - 1))
+
+#ifndef ARENA_POOL_SLAB_SIZE
+#define ARENA_POOL_SLAB_SIZE (16 * 1024)
+#endif
+
+/*
+  Size classes on top of an arena, the class `i` holds the blocks of 
+  ARENA_POOL_MIN_SIZE << i bytes. Every class carves its blocks out of 
+  a slab allocated from the arena, the freed blocks are kept in an 
+  intrusive free list.
+*/
+typedef struct {
+    arena_t* arena;
+
+    void* free_lists[ARENA_POOL_CLASSES_COUNT];
+
+    uint8_t* slabs[ARENA_POOL_CLASSES_COUNT];
+    uint8_t* slab_ends[ARENA_POOL_CLASSES_COUNT];
+} arena_pool_t;
+
 arena_t create_arena(size_t size);
+arena_t create_aligned_arena(size_t size, size_t alignment);
+
+#ifdef ARENA_CHUNK_POOL
+
+arena_chunk_pool_t create_arena_chunk_pool(size_t chunk_size);
+void destroy_arena_chunk_pool(arena_chunk_pool_t* restrict pool);
+
+void arena_chunk_pool_set_max_size(arena_chunk_pool_t* restrict pool, size_t max_size);
+void arena_chunk_pool_trim(arena_chunk_pool_t* restrict pool, size_t max_size);
+
+#ifdef ARENA_CHUNK_POOL_GLOBAL
+arena_chunk_pool_t* arena_chunk_pool_get_global(void);
+#endif
+
+arena_t arena_chunk_pool_create_arena(arena_chunk_pool_t* pool);
+
+#endif
+
+void arena_init_with_buffer(arena_t* restrict arena, void* buffer, size_t size);
+arena_t create_child_arena(arena_t* parent, size_t size);
+
+void arena_set_max_chunk_size(arena_t* restrict arena, size_t max_chunk_size);
+
+arena_stats_t arena_get_stats(const arena_t* restrict arena);
+const arena_chunk_t* arena_get_chunk(const arena_t* restrict arena, size_t chunk_index);
+void arena_set_hooks(arena_t* restrict arena, const arena_hooks_t* hooks);
 
 void* arena_alloc(arena_t* restrict arena, size_t size);
+void* arena_alloc_aligned(arena_t* restrict arena, size_t size, size_t alignment);
+
+void* arena_alloc_array(arena_t* restrict arena, 
+                        size_t count, 
+                        size_t size, 
+                        size_t alignment);
+
+void* arena_alloc_batch(arena_t* restrict arena, 
+                        void** restrict ptrs, 
+                        size_t count, 
+                        size_t size, 
+                        size_t alignment);
+
+void* arena_calloc(arena_t* restrict arena, size_t count, size_t size);
 
 void* arena_realloc(arena_t* restrict arena, 
                     const void* restrict ptr,
                     size_t old_size, 
                     size_t new_size);
 
+void arena_free_last(arena_t* restrict arena, const void* restrict ptr, size_t size);
+
 char* arena_strdup(arena_t* restrict arena, 
                    const char* restrict str);
 
@@ -38,8 +313,114 @@ char* arena_strndup(arena_t* restrict arena,
                     const char* restrict str, 
                     size_t length);
 
+arena_vec_t create_arena_vec(arena_t* arena, size_t element_size);
+
+void* arena_vec_push(arena_vec_t* restrict vec, const void* restrict element);
+void* arena_vec_push_n(arena_vec_t* restrict vec, 
+                       const void* restrict elements, 
+                       size_t count);
+
+void arena_vec_reserve(arena_vec_t* restrict vec, size_t capacity);
+void* arena_vec_finalize(arena_vec_t* restrict vec);
+
+#define ARENA_VEC_AT(vec, type, index) (((type*)(vec)->data)[index])
+
+arena_strbuf_t create_arena_strbuf(arena_t* arena);
+
+void arena_strbuf_append(arena_strbuf_t* restrict strbuf, const char* restrict str);
+void arena_strbuf_appendn(arena_strbuf_t* restrict strbuf, 
+                          const char* restrict str, 
+                          size_t length);
+
+#if defined(__GNUC__)
+__attribute__((format(printf, 2, 3)))
+#endif
+void arena_strbuf_appendf(arena_strbuf_t* restrict strbuf, const char* restrict format, ...);
+
+char* arena_strbuf_finalize(arena_strbuf_t* restrict strbuf);
+
+arena_map_t create_arena_map(arena_t* arena, size_t capacity);
+
+void* arena_map_get(const arena_map_t* restrict map, const void* key, size_t key_length);
+void arena_map_put(arena_map_t* restrict map, const void* key, size_t key_length, void* value);
+
+arena_interner_t create_arena_interner(arena_t* arena);
+
+const char* arena_intern(arena_interner_t* restrict interner, const char* restrict str);
+const char* arena_internn(arena_interner_t* restrict interner, 
+                          const char* restrict str, 
+                          size_t length);
+
+size_t arena_intern_id(arena_interner_t* restrict interner, 
+                       const char* restrict str, 
+                       size_t length);
+const char* arena_interned_string(const arena_interner_t* restrict interner, size_t id);
+
+arena_pool_t create_arena_pool(arena_t* arena);
+
+void* arena_pool_alloc(arena_pool_t* restrict pool, size_t size);
+void arena_pool_free(arena_pool_t* restrict pool, void* ptr, size_t size);
+
+void arena_set_max_retained_size(arena_t* restrict arena, size_t max_retained_size);
+
+void arena_reset(arena_t* restrict arena);
+
+arena_mark_t arena_save(const arena_t* restrict arena);
+void arena_restore(arena_t* restrict arena, arena_mark_t mark);
+
 void destroy_arena(arena_t* restrict arena);
 
+#ifdef ARENA_CHECKED
+
+int arena_validate(const arena_t* restrict arena);
+
+#endif
+
+#ifdef ARENA_PREFAULT
+
+void arena_prefault(arena_t* restrict arena);
+
+#endif
+
+#ifdef ARENA_PREFAULT_THREAD
+
+void arena_start_prefault_thread(arena_t* restrict arena);
+void arena_stop_prefault_thread(arena_t* restrict arena);
+
+#endif
+
+#ifdef ARENA_SNAPSHOT
+
+/*
+  A position independent pointer into an arena: the offset of the 
+  target in the snapshot image of the arena. 0 is the NULL pointer.
+*/
+typedef struct {
+    uint64_t offset;
+} arena_rel_ptr_t;
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+
+    arena_rel_ptr_t root;
+} arena_snapshot_t;
+
+arena_rel_ptr_t arena_to_rel_ptr(const arena_t* restrict arena, const void* ptr);
+void* arena_from_rel_ptr(const arena_t* restrict arena, arena_rel_ptr_t rel_ptr);
+
+int arena_write_snapshot(const arena_t* restrict arena, 
+                         const void* root, 
+                         const char* restrict path);
+
+arena_snapshot_t arena_map_snapshot(const char* restrict path);
+void arena_unmap_snapshot(arena_snapshot_t* restrict snapshot);
+
+const void* arena_snapshot_ptr(const arena_snapshot_t* restrict snapshot, arena_rel_ptr_t rel_ptr);
+const void* arena_snapshot_root(const arena_snapshot_t* restrict snapshot);
+
+#endif
+
 #ifdef ARENA_DEBUG_MODE
 
 int arena_get_chunks_count(const arena_t* restrict arena);
@@ -53,6 +434,10 @@ size_t arena_get_current_used_space(const arena_t* restrict arena);
 
 #endif
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
 
 #ifdef ARENA_IMPLEMENTATION
@@ -72,163 +457,3103 @@ size_t arena_get_current_used_space(const arena_t* restrict arena);
 #define ARENA_ASSERT(condition, message) assert((condition) && (message))
 #endif
 
+#define ARENA_ATOMIC_LOAD(object) __atomic_load_n(&(object), __ATOMIC_ACQUIRE)
+#define ARENA_ATOMIC_STORE(object, value) __atomic_store_n(&(object), (value), __ATOMIC_RELEASE)
+#define ARENA_ATOMIC_EXCHANGE(object, value) __atomic_exchange_n(&(object), (value), __ATOMIC_ACQ_REL)
+#define ARENA_ATOMIC_CAS(object, expected, desired)                     \
+    __atomic_compare_exchange_n(&(object), &(expected), (desired), 0,   \
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#define ARENA_ATOMIC_ADD(object, value) __atomic_add_fetch(&(object), (value), __ATOMIC_RELAXED)
+#define ARENA_ATOMIC_SUB(object, value) __atomic_sub_fetch(&(object), (value), __ATOMIC_RELAXED)
+
+/*
+  With ARENA_THREAD_SAFE defined, the bump offset of the chunks and the 
+  chunks list are updated with atomic operations (GCC/Clang builtins), 
+  so arena_alloc can be called concurrently on the same arena.
+*/
+#ifdef ARENA_THREAD_SAFE
+#define ARENA_LOAD(object) ARENA_ATOMIC_LOAD(object)
+#define ARENA_STORE(object, value) ARENA_ATOMIC_STORE(object, value)
+#define ARENA_CAS(object, expected, desired) ARENA_ATOMIC_CAS(object, expected, desired)
+#else
+#define ARENA_LOAD(object) (object)
+#define ARENA_STORE(object, value) ((object) = (value))
+#define ARENA_CAS(object, expected, desired) ((object) = (desired), 1)
+#endif
+
+// The statistics don't order any memory access, they're relaxed.
+#ifdef ARENA_THREAD_SAFE
+#define ARENA_ADD(object, value) __atomic_add_fetch(&(object), (value), __ATOMIC_RELAXED)
+#define ARENA_SUB(object, value) __atomic_sub_fetch(&(object), (value), __ATOMIC_RELAXED)
+#define ARENA_COUNTER(object) __atomic_load_n(&(object), __ATOMIC_RELAXED)
+#else
+#define ARENA_ADD(object, value) ((object) += (value))
+#define ARENA_SUB(object, value) ((object) -= (value))
+#define ARENA_COUNTER(object) (object)
+#endif
+
+/*
+  The per-allocation counters (requested, padding, used, peak_used) would make 
+  every thread hit the same cache line in thread safe mode: they're only kept 
+  there with ARENA_THREAD_SAFE_STATS, the used space is summed from the chunks.
+*/
+#if !defined(ARENA_THREAD_SAFE) || defined(ARENA_THREAD_SAFE_STATS)
+#define ARENA_ALLOCATION_STATS
+#endif
+
+/*
+  The chunk directory is only updated on the slow path (a new chunk), 
+  in thread safe mode it's guarded by a spinlock. The locks live in the 
+  side structures of the arena, so they can be taken through a const 
+  arena.
+*/
+#ifdef ARENA_THREAD_SAFE
+#define ARENA_LOCK(lock)                                                    \
+    do {                                                                    \
+        while(__atomic_exchange_n(&(lock), 1, __ATOMIC_ACQUIRE)) {          \
+            while(__atomic_load_n(&(lock), __ATOMIC_RELAXED));              \
+        }                                                                   \
+    } while(0)
+#define ARENA_UNLOCK(lock) __atomic_store_n(&(lock), 0, __ATOMIC_RELEASE)
+#else
+#define ARENA_LOCK(lock) ((void) (lock))
+#define ARENA_UNLOCK(lock) ((void) (lock))
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
 
-static arena_chunk_t* new_arena_chunk(size_t size) {
+// Marks the chunks that aren't in the free space index.
+#define ARENA_NO_BIN SIZE_MAX
 
-    arena_chunk_t* const chunk = ARENA_MALLOC(sizeof(arena_chunk_t) + size);
-    ARENA_ASSERT(chunk != NULL, "Unable to allocate memory!");
+#ifdef ARENA_REDUCE_FRAGMENTATION
+#define ARENA_CHUNK_UNBIN(chunk) ((chunk)->bin = ARENA_NO_BIN)
+#else
+#define ARENA_CHUNK_UNBIN(chunk) ((void) (chunk))
+#endif
 
-    chunk->used = 0;
-    chunk->size = size;
-    chunk->next = NULL;
+#ifdef ARENA_CHECKED
 
-    return chunk;
-}
+#ifndef ARENA_REDZONE_SIZE
+#define ARENA_REDZONE_SIZE 16
+#endif
 
-arena_t create_arena(size_t size) {
-    arena_t arena;
+// Fills the redzones, and the memory given back by a reset or a restore.
+#define ARENA_REDZONE_BYTE 0xFD
+#define ARENA_RELEASED_BYTE 0xDD
 
-    arena.begin = new_arena_chunk(size);
-    arena.end = arena.begin;
+#if defined(__SANITIZE_ADDRESS__)
+#define ARENA_ASAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ARENA_ASAN
+#endif
+#endif
 
-    return arena;
-}
+#endif
 
-void* arena_alloc(arena_t* restrict arena, size_t size) {
+/*
+  Under AddressSanitizer, checked mode poisons the redzones and the 
+  released memory, so the faulty access is reported where it happens.
+*/
+#ifdef ARENA_ASAN
+#include <sanitizer/asan_interface.h>
+#define ARENA_ASAN_GRANULARITY 8
+#define ARENA_POISON(ptr, size) ASAN_POISON_MEMORY_REGION((ptr), (size))
+#define ARENA_UNPOISON(ptr, size) ASAN_UNPOISON_MEMORY_REGION((ptr), (size))
+#else
+#define ARENA_POISON(ptr, size) ((void) (ptr), (void) (size))
+#define ARENA_UNPOISON(ptr, size) ((void) (ptr), (void) (size))
+#endif
 
-    if(size <= 0) return NULL;
+#if defined(ARENA_VIRTUAL_MEMORY) || defined(ARENA_HUGE_PAGES)
 
-#ifdef ARENA_REDUCE_FRAGMENTATION
+/*
+  With ARENA_VIRTUAL_MEMORY, every chunk reserves a large range of 
+  virtual memory, but only the pages below `size` are committed 
+  (readable and writable). The chunk grows in place, up to `capacity`, 
+  by committing more pages.
 
-    /*
-      With this, we'll reduce internal fragmentation by searching 
-      for "holes" not big enough for previous allocations but large 
-      enough for the current one.
-    */
-    
-    arena_chunk_t* current = arena->begin;
+  With ARENA_HUGE_PAGES, the chunks are mapped at a huge page boundary 
+  and their size is a multiple of the huge page size. 
+  Explicit huge pages (MAP_HUGETLB) are tried first, then transparent 
+  huge pages are requested with madvise(MADV_HUGEPAGE).
+*/
 
-    while(current->next != NULL) {
-        if(current->used + size <= current->size) {
-            break;
-        }
+#include <sys/mman.h>
 
-        current = current->next;
-    }
-#else
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
 
-    arena_chunk_t* current = arena->end;
+// MAP_ANONYMOUS and madvise() are hidden by a strict -std=c99 without a feature macro.
+#if defined(ARENA_VIRTUAL_MEMORY) && (!defined(MAP_ANONYMOUS) || !defined(MADV_DONTNEED))
+#error "ARENA_VIRTUAL_MEMORY requires _DEFAULT_SOURCE (or _GNU_SOURCE) before any system header!"
+#endif
 
+#if defined(ARENA_HUGE_PAGES) && !defined(MAP_ANONYMOUS)
+#error "ARENA_HUGE_PAGES requires _DEFAULT_SOURCE (or _GNU_SOURCE) before any system header!"
 #endif
 
-    if(current->used + size > current->size) {
-        current->next = new_arena_chunk(current->size);
-        arena->end = current->next;
-        current = arena->end;
-    }
+#ifdef ARENA_HUGE_PAGES
+#define ARENA_COMMIT_GRANULARITY HUGE_PAGE_SIZE
+#else
+#define ARENA_COMMIT_GRANULARITY PAGE_SIZE
+#endif
 
-    void* ptr = current->data + current->used;
-    current->used += size;
+#ifndef ARENA_VIRTUAL_MEMORY
+#undef ARENA_RESERVE_SIZE
+#define ARENA_RESERVE_SIZE 0
+#elif !defined(ARENA_RESERVE_SIZE)
+#define ARENA_RESERVE_SIZE ((size_t)1 << (sizeof(void*) >= 8 ? 32 : 28))
+#endif
 
-    return ptr;
+static inline size_t round_to_page_size(size_t size) {
+    return (size + ARENA_COMMIT_GRANULARITY - 1) & ~(size_t)(ARENA_COMMIT_GRANULARITY - 1);
 }
 
-void* arena_realloc(arena_t* restrict arena, 
-                    const void* restrict ptr, 
-                    size_t old_size, 
-                    size_t new_size) {
-    
-    if(new_size <= 0) {
-        return NULL;
-    }
+static void* map_memory(size_t size, int protection) {
 
-    void* new_ptr = arena_alloc(arena, new_size);
+#if defined(ARENA_HUGE_PAGES) && defined(MAP_HUGETLB)
 
-    if(ptr != NULL) {
-        memcpy(new_ptr, ptr, old_size);
-    }
+    // Explicit huge pages are committed upfront, they can't back a reservation.
+    if(protection != PROT_NONE) {
+        void* const memory = 
+            mmap(NULL, size, protection, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
 
-    return new_ptr;
-}
+        if(memory != MAP_FAILED) {
+            return memory;
+        }
+    }
+#endif
 
-inline char* arena_strdup(arena_t* restrict arena, 
-                          const char* restrict str) {
-    return arena_strndup(arena, str, strlen(str));
-}
+#ifdef ARENA_HUGE_PAGES
 
-char* arena_strndup(arena_t* restrict arena, 
-                    const char* restrict str, 
-                    size_t length) {
+    // Maps an extra huge page, so the mapping can be trimmed to a huge page boundary.
+    uint8_t* const memory = 
+        mmap(NULL, size + HUGE_PAGE_SIZE, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 
-    char* const new_str = (char*)arena_alloc(arena, sizeof(char) * length + 1);
+    if(memory == MAP_FAILED) {
+        return MAP_FAILED;
+    }
 
-    memcpy(new_str, str, sizeof(char) * length);
-    new_str[length] = '\0';
+    const uintptr_t address = (uintptr_t)memory;
+    uint8_t* const aligned_memory = 
+        memory + (((address + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1)) - address);
 
-    return new_str;
-}
+    const size_t head_size = (size_t)(aligned_memory - memory);
+    const size_t tail_size = HUGE_PAGE_SIZE - head_size;
 
-void destroy_arena(arena_t* restrict arena) {
+    if(head_size > 0) {
+        munmap(memory, head_size);
+    }
 
-    arena_chunk_t* chunk;
-    arena_chunk_t* it = arena->begin;
+    if(tail_size > 0) {
+        munmap(aligned_memory + size, tail_size);
+    }
 
-    while(it != NULL){
-        chunk = it;
-        it = it->next;
+#ifdef MADV_HUGEPAGE
+    madvise(aligned_memory, size, MADV_HUGEPAGE);
+#endif
 
-        ARENA_FREE(chunk);
-    }
+    return aligned_memory;
+#else
+    return mmap(NULL, size, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#endif
 }
 
-#ifdef ARENA_DEBUG_MODE
+// The usable size of a chunk allocated for `size` bytes.
+static inline size_t arena_chunk_data_size(size_t size) {
+    return round_to_page_size(sizeof(arena_chunk_t) + size) - sizeof(arena_chunk_t);
+}
 
-int arena_get_chunks_count(const arena_t* restrict arena) {
-    int count = 0;
+static arena_chunk_t* new_arena_chunk(size_t size) {
 
-    for(const arena_chunk_t* it = arena->begin; 
-        it != NULL; 
-        it = it->next) {
+    ARENA_ASSERT(size <= SIZE_MAX - sizeof(arena_chunk_t) - (ARENA_COMMIT_GRANULARITY - 1), 
+                 "Chunk size overflow!");
 
-        count++;
-    }
+    const size_t committed_size = round_to_page_size(sizeof(arena_chunk_t) + size);
+    const size_t reserved_size = (committed_size > ARENA_RESERVE_SIZE)
+        ? committed_size 
+        : round_to_page_size(ARENA_RESERVE_SIZE);
 
-    return count;
-}
+#ifdef ARENA_VIRTUAL_MEMORY
+    void* const memory = map_memory(reserved_size, PROT_NONE);
+    ARENA_ASSERT(memory != MAP_FAILED, "Unable to reserve memory!");
 
-size_t arena_get_available_space_of(const arena_t* restrict arena, int chunk_index) {
+    const int result = mprotect(memory, committed_size, PROT_READ | PROT_WRITE);
+    ARENA_ASSERT(result == 0, "Unable to commit memory!");
+    (void) result;
+#else
+    void* const memory = map_memory(reserved_size, PROT_READ | PROT_WRITE);
+    ARENA_ASSERT(memory != MAP_FAILED, "Unable to allocate memory!");
+#endif
 
-    if(chunk_index > arena_get_chunks_count(arena) || chunk_index < 0) {
-        return 0;
-    }
+    arena_chunk_t* const chunk = (arena_chunk_t*)memory;
 
-    const arena_chunk_t* it = arena->begin;
+    chunk->used = 0;
+    chunk->size = committed_size - sizeof(arena_chunk_t);
+    chunk->capacity = reserved_size - sizeof(arena_chunk_t);
+    chunk->dirty = 0;
+    chunk->next = NULL;
+    ARENA_CHUNK_UNBIN(chunk);
 
-    for(int i = 0; i < chunk_index; i++) {
-        it = it->next;
-    }
+    return chunk;
+}
 
-    return (it->size - it->used);
+static inline void delete_arena_chunk(arena_chunk_t* chunk) {
+    munmap(chunk, sizeof(arena_chunk_t) + chunk->capacity);
 }
 
-inline size_t arena_get_current_available_space(const arena_t* restrict arena) {
-    return (arena->end->size - arena->end->used);
+#else
+
+static inline size_t arena_chunk_data_size(size_t size) {
+    return size;
 }
 
-size_t arena_get_used_space_of(const arena_t* restrict arena, int chunk_index) {
+static arena_chunk_t* new_arena_chunk(size_t size) {
 
-    if(chunk_index > arena_get_chunks_count(arena) || chunk_index < 0) {
-        return 0;
-    }
+    ARENA_ASSERT(size <= SIZE_MAX - sizeof(arena_chunk_t), "Chunk size overflow!");
 
-    const arena_chunk_t* it = arena->begin;
+#ifdef ARENA_CALLOC
+    arena_chunk_t* const chunk = ARENA_CALLOC(1, sizeof(arena_chunk_t) + size);
+#else
+    arena_chunk_t* const chunk = ARENA_MALLOC(sizeof(arena_chunk_t) + size);
+#endif
+    ARENA_ASSERT(chunk != NULL, "Unable to allocate memory!");
 
-    for(int i = 0; i < chunk_index; i++) {
-        it = it->next;
+    chunk->used = 0;
+    chunk->size = size;
+    chunk->capacity = size;
+#ifdef ARENA_CALLOC
+    chunk->dirty = 0;
+#else
+    chunk->dirty = size;
+#endif
+    chunk->next = NULL;
+    ARENA_CHUNK_UNBIN(chunk);
+
+    return chunk;
+}
+
+static inline void delete_arena_chunk(arena_chunk_t* chunk) {
+    ARENA_FREE(chunk);
+}
+
+#endif
+
+/*
+  Grows the chunk in place, so that at least `required_size` bytes 
+  are usable. It returns 0 if the chunk can't grow that much, which 
+  is always the case for the malloc backed chunks. 
+  Pages are committed in steps of the arena chunk size.
+*/
+static int arena_chunk_commit(arena_t* restrict arena, 
+                              arena_chunk_t* chunk, 
+                              size_t required_size) {
+#ifdef ARENA_VIRTUAL_MEMORY
+
+    if(required_size > chunk->capacity) {
+        return 0;
+    }
+
+    size_t committed_size = ARENA_LOAD(chunk->size);
+    size_t target_size = committed_size + arena->chunk_size;
+
+    if(target_size < required_size) {
+        target_size = required_size;
+    }
+
+    target_size = round_to_page_size(sizeof(arena_chunk_t) + target_size) - sizeof(arena_chunk_t);
+
+    if(target_size > chunk->capacity) {
+        target_size = chunk->capacity;
+    }
+
+    const int result = mprotect(chunk, sizeof(arena_chunk_t) + target_size, PROT_READ | PROT_WRITE);
+    ARENA_ASSERT(result == 0, "Unable to commit memory!");
+    (void) result;
+
+    // Another thread could have committed a larger range in the meantime.
+    while(committed_size < target_size) {
+        if(ARENA_CAS(chunk->size, committed_size, target_size)) {
+            (void) ARENA_ADD(arena->stats.capacity, target_size - committed_size);
+            break;
+        }
+    }
+
+    return 1;
+#else
+    (void) arena;
+    (void) chunk;
+    (void) required_size;
+
+    return 0;
+#endif
+}
+
+/*
+  Gives the physical pages of the chunk beyond `retained_size` bytes 
+  back to the operating system, they'll be zero filled on the next use.
+*/
+static void arena_chunk_purge(arena_chunk_t* chunk, size_t retained_size) {
+#if defined(ARENA_VIRTUAL_MEMORY) || defined(ARENA_HUGE_PAGES)
+
+    if(retained_size >= chunk->size) {
+        return;
+    }
+
+    const size_t begin = round_to_page_size(sizeof(arena_chunk_t) + retained_size);
+    const size_t end = sizeof(arena_chunk_t) + chunk->size;
+
+    if(begin < end) {
+        madvise((uint8_t*)chunk + begin, end - begin, MADV_DONTNEED);
+
+        // The released pages are zero filled on the next access.
+        if(chunk->dirty > begin - sizeof(arena_chunk_t)) {
+            chunk->dirty = begin - sizeof(arena_chunk_t);
+        }
+    }
+#else
+    (void) chunk;
+    (void) retained_size;
+#endif
+}
+
+// The size of the next regular chunk.
+static inline size_t arena_next_chunk_size(const arena_t* restrict arena) {
+
+    const size_t chunk_size = ARENA_LOAD(arena->chunk_size);
+
+    if(chunk_size >= arena->max_chunk_size) {
+        return chunk_size;
+    }
+
+    return (chunk_size > arena->max_chunk_size / ARENA_GROWTH_FACTOR)
+        ? arena->max_chunk_size
+        : chunk_size * ARENA_GROWTH_FACTOR;
+}
+
+#ifdef ARENA_PREFAULT
+
+/*
+  Faults the pages of a new chunk in, so the first allocations don't 
+  pay for the page faults. The content of a new chunk is either unknown 
+  or zero, so the pages can be touched by writing a zero.
+*/
+static void arena_chunk_prefault(arena_chunk_t* chunk) {
+
+#if (defined(ARENA_VIRTUAL_MEMORY) || defined(ARENA_HUGE_PAGES)) && defined(MADV_POPULATE_WRITE)
+    if(madvise(chunk, sizeof(arena_chunk_t) + chunk->size, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+
+    volatile uint8_t* const data = chunk->data;
+
+    for(size_t offset = 0; offset < chunk->size; offset += PAGE_SIZE) {
+        data[offset] = 0;
+    }
+}
+
+static void arena_release_chunk(arena_t* restrict arena, arena_chunk_t* chunk);
+
+/*
+  Takes the spare chunk for a regular chunk of `size` bytes, a dedicated 
+  chunk (larger than the next regular one) leaves the spare alone. 
+  The size of the spare is only read once it's owned: a spare prepared 
+  before the chunk size grew is undersized, it's released so that the 
+  next prefault prepares one of the new size.
+*/
+static arena_chunk_t* arena_take_spare(arena_t* restrict arena, size_t size) {
+
+    arena_chunk_t* spare = ARENA_LOAD(arena->spare);
+
+    if(spare == NULL || size > arena_next_chunk_size(arena) || !ARENA_CAS(arena->spare, spare, NULL)) {
+        return NULL;
+    }
+
+    if(spare->size < size) {
+        arena_release_chunk(arena, spare);
+        return NULL;
+    }
+
+    return spare;
+}
+
+#endif
+
+/*
+  Moves the used space of the chunk back to `used`. The bytes 
+  below the dirty watermark may have been written, the ones above 
+  it are known to be zero.
+*/
+static inline void arena_chunk_rewind(arena_chunk_t* chunk, size_t used) {
+
+    if(chunk->used > chunk->dirty) {
+        chunk->dirty = chunk->used;
+    }
+
+#ifdef ARENA_CHECKED
+    // A use after reset reads garbage (or is reported by ASan).
+    if(used < chunk->used) {
+        ARENA_UNPOISON(chunk->data + used, chunk->used - used);
+        memset(chunk->data + used, ARENA_RELEASED_BYTE, chunk->used - used);
+        ARENA_POISON(chunk->data + used, chunk->used - used);
+    }
+#endif
+
+    chunk->used = used;
+}
+
+static inline size_t floor_log2(size_t value) {
+#if defined(__GNUC__)
+    return (size_t)(63 - __builtin_clzll((unsigned long long)value));
+#else
+    size_t result = 0;
+    while(value >>= 1) result++;
+    return result;
+#endif
+}
+
+static inline size_t round_to_power_of_two(size_t value) {
+    ARENA_ASSERT(value <= ((size_t)1 << (sizeof(size_t) * 8 - 1)), "Chunk size overflow!");
+    return (value <= 1) ? 1 : (size_t)1 << (floor_log2(value - 1) + 1);
+}
+
+#ifdef ARENA_CHUNK_POOL
+
+/*
+  Every bucket of the chunk pool is a lock-free stack (a Treiber stack) 
+  shared across threads. The head of a bucket pairs the first chunk with 
+  a generation tag, the tag is bumped by every push and pop, so a pop 
+  that read a stale link never succeeds (the ABA problem). The tag is 
+  as wide as a pointer: on 64 bits platforms it doesn't wrap around in 
+  practice, a stalled pop would have to miss 2^64 updates. The chunk 
+  and the tag are swapped together with a double-width CAS (cmpxchg16b 
+  on x86-64, through libatomic with GCC).
+
+  A pop reads the link of a chunk it doesn't own yet, another thread 
+  could have popped the same chunk in the meantime. The pops announce 
+  themselves in `poppers`, and a chunk popped from the pool is only 
+  freed once no pop is in progress (see arena_chunk_pool_collect).
+*/
+static inline arena_chunk_pool_bucket_t arena_chunk_pool_read(arena_chunk_pool_bucket_t* bucket) {
+    arena_chunk_pool_bucket_t head;
+    __atomic_load(bucket, &head, __ATOMIC_SEQ_CST);
+
+    return head;
+}
+
+/*
+  Replaces `head` with `first` as the first chunk of the bucket, the tag 
+  wraps around. On failure, `head` is updated to the current head.
+*/
+static inline int arena_chunk_pool_replace(arena_chunk_pool_bucket_t* bucket, 
+                                           arena_chunk_pool_bucket_t* head, 
+                                           arena_chunk_t* first) {
+    arena_chunk_pool_bucket_t desired;
+
+    desired.first = first;
+    desired.tag = head->tag + 1;
+
+    return __atomic_compare_exchange(bucket, head, &desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static void arena_chunk_pool_push(arena_chunk_pool_bucket_t* bucket, arena_chunk_t* chunk) {
+
+    arena_chunk_pool_bucket_t head = arena_chunk_pool_read(bucket);
+
+    do {
+        ARENA_ATOMIC_STORE(chunk->next, head.first);
+    } while(!arena_chunk_pool_replace(bucket, &head, chunk));
+}
+
+// Adds the chunks linked from `chunks` to the retired chunks of the pool.
+static void arena_chunk_pool_retire(arena_chunk_pool_t* pool, arena_chunk_t* chunks) {
+
+    arena_chunk_t* last = chunks;
+
+    while(ARENA_ATOMIC_LOAD(last->next) != NULL) {
+        last = ARENA_ATOMIC_LOAD(last->next);
+    }
+
+    arena_chunk_t* head = ARENA_ATOMIC_LOAD(pool->retired);
+
+    do {
+        ARENA_ATOMIC_STORE(last->next, head);
+    } while(!ARENA_ATOMIC_CAS(pool->retired, head, chunks));
+}
+
+/*
+  Frees the retired chunks if no pop is in progress, otherwise they 
+  stay retired until a later pop or trim. The chunks are taken before 
+  the counter is read: they had all left the pool by then, so no pop 
+  started since can read their links. Nothing waits for the pops.
+*/
+static void arena_chunk_pool_collect(arena_chunk_pool_t* pool) {
+
+    arena_chunk_t* retired = __atomic_exchange_n(&pool->retired, NULL, __ATOMIC_SEQ_CST);
+
+    if(retired == NULL) {
+        return;
+    }
+
+    if(__atomic_load_n(&pool->poppers, __ATOMIC_SEQ_CST) != 0) {
+        arena_chunk_pool_retire(pool, retired);
+        return;
+    }
+
+    while(retired != NULL) {
+        arena_chunk_t* const chunk = retired;
+        retired = retired->next;
+
+        delete_arena_chunk(chunk);
+    }
+}
+
+/*
+  Pops the first chunk of a bucket. The counter and the head are 
+  sequentially consistent: a thread that sees no popper after a 
+  chunk left the pool knows no pop can still read its link. The 
+  last pop in progress frees the retired chunks.
+*/
+static arena_chunk_t* arena_chunk_pool_pop_bucket(arena_chunk_pool_t* pool, arena_chunk_pool_bucket_t* bucket) {
+
+    (void) __atomic_add_fetch(&pool->poppers, 1, __ATOMIC_SEQ_CST);
+
+    arena_chunk_pool_bucket_t head = arena_chunk_pool_read(bucket);
+    arena_chunk_t* chunk;
+
+    while((chunk = head.first) != NULL) {
+        if(arena_chunk_pool_replace(bucket, &head, ARENA_ATOMIC_LOAD(chunk->next))) {
+            break;
+        }
+    }
+
+    if(__atomic_sub_fetch(&pool->poppers, 1, __ATOMIC_SEQ_CST) == 0 && 
+       ARENA_ATOMIC_LOAD(pool->retired) != NULL) {
+        arena_chunk_pool_collect(pool);
+    }
+
+    return chunk;
+}
+
+/*
+  Frees a chunk that may have been in the pool. A pop in progress could 
+  still read its link: the chunk is retired, and freed once the pops 
+  are over.
+*/
+static void arena_chunk_pool_delete(arena_chunk_pool_t* pool, arena_chunk_t* chunk) {
+
+    ARENA_ATOMIC_STORE(chunk->next, NULL);
+
+    arena_chunk_pool_retire(pool, chunk);
+    arena_chunk_pool_collect(pool);
+}
+
+/*
+  Pops a chunk of at least `size` bytes. The chunks allocated for 
+  the same (power of two) size land in the same bucket, so the 
+  head of the bucket is the only candidate.
+*/
+static arena_chunk_t* arena_chunk_pool_pop(arena_chunk_pool_t* pool, size_t size) {
+
+    arena_chunk_pool_bucket_t* const bucket = &pool->buckets[floor_log2(arena_chunk_data_size(size))];
+    arena_chunk_t* const chunk = arena_chunk_pool_pop_bucket(pool, bucket);
+
+    if(chunk == NULL) {
+        return NULL;
+    }
+
+    // The size is only read once the chunk is owned.
+    if(chunk->size < size) {
+        arena_chunk_pool_push(bucket, chunk);
+        return NULL;
+    }
+
+    (void) ARENA_ATOMIC_SUB(pool->size, chunk->size);
+
+    arena_chunk_rewind(chunk, 0);
+    ARENA_ATOMIC_STORE(chunk->next, NULL);
+    ARENA_CHUNK_UNBIN(chunk);
+
+    return chunk;
+}
+
+// Returns 0 if the pool is full, the chunk must be freed.
+static int arena_chunk_pool_put(arena_chunk_pool_t* pool, arena_chunk_t* chunk) {
+
+    if(ARENA_ATOMIC_ADD(pool->size, chunk->size) > pool->max_size) {
+        (void) ARENA_ATOMIC_SUB(pool->size, chunk->size);
+        return 0;
+    }
+
+    arena_chunk_pool_push(&pool->buckets[floor_log2(chunk->size)], chunk);
+
+    return 1;
+}
+
+#endif
+
+#ifdef ARENA_SNAPSHOT
+
+/*
+  Every chunk gets its own range of the snapshot image, a chunk 
+  never moves in the image once it has been acquired. The range 
+  keeps the page offset of the chunk data, so the mapped image 
+  honors the alignment of the allocations.
+  The first page of the image is the snapshot header.
+*/
+static void arena_place_chunk(arena_t* restrict arena, arena_chunk_t* chunk) {
+
+    const size_t page_offset = (size_t)((uintptr_t)chunk->data & (PAGE_SIZE - 1));
+    const size_t range_size = 
+        (page_offset + chunk->capacity + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+
+    chunk->image_offset = ARENA_ADD(arena->image_size, range_size) - range_size + page_offset;
+}
+
+#else
+
+static inline void arena_place_chunk(arena_t* restrict arena, arena_chunk_t* chunk) {
+    (void) arena;
+    (void) chunk;
+}
+
+#endif
+
+/*
+  Places a chunk, header included, in memory the arena doesn't own. 
+  The content of the memory is unknown, the whole chunk is dirty.
+*/
+static arena_chunk_t* arena_chunk_from_buffer(void* buffer, size_t size) {
+
+    const uintptr_t address = (uintptr_t)buffer;
+    const size_t header_offset = (size_t)(((address + ARENA_ALIGNOF(arena_chunk_t) - 1) & 
+                                           ~(uintptr_t)(ARENA_ALIGNOF(arena_chunk_t) - 1)) - address);
+
+    ARENA_ASSERT(buffer != NULL && size >= header_offset + sizeof(arena_chunk_t), "Buffer too small!");
+
+    arena_chunk_t* const chunk = (arena_chunk_t*)((uint8_t*)buffer + header_offset);
+
+    chunk->used = 0;
+    chunk->size = size - header_offset - sizeof(arena_chunk_t);
+    chunk->capacity = chunk->size;
+    chunk->dirty = chunk->size;
+    chunk->next = NULL;
+    ARENA_CHUNK_UNBIN(chunk);
+
+    return chunk;
+}
+
+// The chunks of a child arena are allocations of its parent.
+static arena_chunk_t* arena_carve_chunk(arena_t* restrict parent, size_t size) {
+    
+    ARENA_ASSERT(size <= SIZE_MAX - sizeof(arena_chunk_t), "Chunk size overflow!");
+
+    void* const memory = 
+        arena_alloc_aligned(parent, sizeof(arena_chunk_t) + size, ARENA_ALIGNOF(arena_chunk_t));
+
+    return arena_chunk_from_buffer(memory, sizeof(arena_chunk_t) + size);
+}
+
+// The bytes in use, summed from the chunks without ARENA_ALLOCATION_STATS.
+static size_t arena_used_space(const arena_t* restrict arena) {
+
+#ifdef ARENA_ALLOCATION_STATS
+    return ARENA_COUNTER(arena->stats.used);
+#else
+    size_t used = 0;
+
+    for(const arena_chunk_t* it = arena->begin; it != NULL; it = ARENA_LOAD(it->next)) {
+        used += ARENA_LOAD(it->used);
+    }
+
+    return used;
+#endif
+}
+
+/*
+  Extends the range carved by the children with a chunk carved from `used` 
+  to `carved_used`. Once the parent has been used in between, the range 
+  can't be rolled back until all the children are destroyed.
+*/
+static void arena_track_children(arena_t* restrict parent, size_t used, size_t carved_used) {
+    ARENA_STORE(parent->children_used, (ARENA_LOAD(parent->children_used) == used) ? carved_used : SIZE_MAX);
+}
+
+/*
+  The chunks of a pooled arena are rounded to a power of two, so they can be 
+  recycled for any request of the same bucket.
+*/
+static arena_chunk_t* arena_allocate_chunk(arena_t* restrict arena, size_t size) {
+
+    arena_chunk_t* chunk = NULL;
+
+    if(arena->parent != NULL) {
+        const size_t used = arena_used_space(arena->parent);
+        chunk = arena_carve_chunk(arena->parent, size);
+
+        const size_t carved_used = arena_used_space(arena->parent);
+        (void) ARENA_ADD(arena->parent_used, carved_used - used);
+        arena_track_children(arena->parent, used, carved_used);
+    }
+#ifdef ARENA_CHUNK_POOL
+    else if(arena->chunk_pool != NULL) {
+        size = round_to_power_of_two(size);
+        chunk = arena_chunk_pool_pop(arena->chunk_pool, size);
+    }
+#endif
+
+    if(chunk == NULL) {
+        (void) ARENA_ADD(arena->stats.malloc_calls, 1);
+        chunk = new_arena_chunk(size);
+    }
+
+    return chunk;
+}
+
+/*
+  The spare chunk is preferred. The data of a new chunk is poisoned, 
+  every allocation unpoisons its own bytes.
+*/
+static arena_chunk_t* arena_acquire_chunk(arena_t* restrict arena, size_t size) {
+
+#ifdef ARENA_PREFAULT
+    arena_chunk_t* chunk = arena_take_spare(arena, size);
+
+    if(chunk == NULL) {
+        chunk = arena_allocate_chunk(arena, size);
+    }
+#else
+    arena_chunk_t* const chunk = arena_allocate_chunk(arena, size);
+#endif
+
+    ARENA_POISON(chunk->data, chunk->size);
+    arena_place_chunk(arena, chunk);
+
+    return chunk;
+}
+
+/*
+  The largest chunk acquired for a single allocation: the chunk header, 
+  the page rounding and the power of two rounding of the pooled chunks 
+  can't overflow below it.
+*/
+#define ARENA_MAX_ALLOCATION_SIZE (SIZE_MAX >> 1)
+
+/*
+  The chunk directory mirrors the chunks list in an array, so the 
+  chunks can be looked up by index. It's allocated with the second 
+  chunk, a single chunk arena doesn't need it, and it's never 
+  replaced: only its array grows.
+*/
+typedef struct _arena_directory {
+    arena_chunk_t** chunks;
+    size_t size;
+    size_t capacity;
+
+    int lock;
+} arena_directory_t;
+
+static arena_directory_t* new_arena_directory(arena_chunk_t* first) {
+    arena_directory_t* const directory = ARENA_MALLOC(sizeof(arena_directory_t));
+    ARENA_ASSERT(directory != NULL, "Unable to allocate memory!");
+
+    directory->chunks = ARENA_MALLOC(sizeof(arena_chunk_t*) * 16);
+    ARENA_ASSERT(directory->chunks != NULL, "Unable to allocate memory!");
+
+    directory->chunks[0] = first;
+    directory->size = 1;
+    directory->capacity = 16;
+    directory->lock = 0;
+
+    return directory;
+}
+
+static void delete_arena_directory(arena_directory_t* directory) {
+
+    if(directory == NULL) {
+        return;
+    }
+
+    ARENA_FREE(directory->chunks);
+    ARENA_FREE(directory);
+}
+
+// The directory of the arena, in thread safe mode the first one installed wins.
+static arena_directory_t* arena_get_directory(arena_t* restrict arena) {
+
+    arena_directory_t* directory = ARENA_LOAD(arena->directory);
+
+    if(directory != NULL) {
+        return directory;
+    }
+
+    directory = new_arena_directory(arena->begin);
+    arena_directory_t* installed = NULL;
+
+    if(!ARENA_CAS(arena->directory, installed, directory)) {
+        delete_arena_directory(directory);
+        return installed;
+    }
+
+    return directory;
+}
+
+/*
+  Makes room for one more chunk in the directory, called with the 
+  directory lock held. The lock is released while the larger array 
+  is allocated, another thread may have grown the directory then.
+*/
+static void arena_directory_reserve(arena_directory_t* directory) {
+
+    while(directory->size == directory->capacity) {
+        const size_t capacity = directory->capacity * 2;
+
+        ARENA_UNLOCK(directory->lock);
+
+        arena_chunk_t** const chunks = ARENA_MALLOC(sizeof(arena_chunk_t*) * capacity);
+        ARENA_ASSERT(chunks != NULL, "Unable to allocate memory!");
+
+        ARENA_LOCK(directory->lock);
+
+        if(directory->capacity >= capacity) {
+            ARENA_FREE(chunks);
+            continue;
+        }
+
+        memcpy(chunks, directory->chunks, sizeof(arena_chunk_t*) * directory->size);
+        ARENA_FREE(directory->chunks);
+
+        directory->chunks = chunks;
+        directory->capacity = capacity;
+    }
+}
+
+/*
+  The chunks are linked before they're added, outside of the lock: 
+  the chunks following `previous` in the list are added up to the 
+  first one already there. In thread safe mode, a chunk installed 
+  after a chunk not added yet is left to the thread adding the 
+  latter, so the directory keeps the order of the list.
+*/
+static void arena_directory_insert(arena_t* restrict arena, const arena_chunk_t* previous) {
+
+    arena_directory_t* const directory = arena_get_directory(arena);
+
+    ARENA_LOCK(directory->lock);
+
+    for(;;) {
+        arena_directory_reserve(directory);
+
+        // The chunk is usually appended, unless the arena has retained chunks after `previous`.
+        size_t position = directory->size;
+
+        while(position > 0 && directory->chunks[position - 1] != previous) {
+            position--;
+        }
+
+        arena_chunk_t* const chunk = (position > 0) ? ARENA_LOAD(previous->next) : NULL;
+
+        if(chunk == NULL || (position < directory->size && directory->chunks[position] == chunk)) {
+            break;
+        }
+
+        memmove(directory->chunks + position + 1, 
+                directory->chunks + position, 
+                sizeof(arena_chunk_t*) * (directory->size - position));
+
+        directory->chunks[position] = chunk;
+        directory->size++;
+
+        previous = chunk;
+    }
+
+    ARENA_UNLOCK(directory->lock);
+}
+
+// Rebuilds the directory after chunks have been removed from the list.
+static void arena_directory_rebuild(arena_t* restrict arena) {
+
+    arena_directory_t* const directory = arena->directory;
+
+    if(directory == NULL) {
+        return;
+    }
+
+    directory->size = 0;
+
+    for(arena_chunk_t* it = arena->begin; it != NULL; it = it->next) {
+        directory->chunks[directory->size++] = it;
+    }
+}
+
+// A chunk joins (or leaves) the chunks list of the arena.
+static void arena_attach_chunk(arena_t* restrict arena, const arena_chunk_t* chunk) {
+
+    (void) ARENA_ADD(arena->stats.chunks_count, 1);
+    (void) ARENA_ADD(arena->stats.capacity, chunk->size);
+
+    if(arena->hooks != NULL && arena->hooks->chunk_acquired != NULL) {
+        arena->hooks->chunk_acquired(arena->hooks->user_data, chunk);
+    }
+}
+
+static void arena_detach_chunk(arena_t* restrict arena, const arena_chunk_t* chunk) {
+
+    (void) ARENA_SUB(arena->stats.chunks_count, 1);
+    (void) ARENA_SUB(arena->stats.capacity, chunk->size);
+
+    if(arena->hooks != NULL && arena->hooks->chunk_released != NULL) {
+        arena->hooks->chunk_released(arena->hooks->user_data, chunk);
+    }
+}
+
+static void arena_release_chunk(arena_t* restrict arena, arena_chunk_t* chunk) {
+
+    ARENA_UNPOISON(chunk->data, chunk->size);
+
+    // The caller owns the buffer of the first chunk, the parent owns the chunks of a child.
+    if(chunk == arena->buffer || arena->parent != NULL) {
+        return;
+    }
+
+#ifdef ARENA_CHUNK_POOL
+    if(arena->chunk_pool != NULL) {
+        if(!arena_chunk_pool_put(arena->chunk_pool, chunk)) {
+            arena_chunk_pool_delete(arena->chunk_pool, chunk);
+        }
+
+        return;
+    }
+#endif
+
+    delete_arena_chunk(chunk);
+}
+
+static inline int is_power_of_two(size_t value) {
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+/*
+  Returns the offset (relative to the chunk data) of the first address
+  after `used` bytes that satisfies the requested alignment.
+*/
+static inline size_t arena_chunk_aligned_offset(const arena_chunk_t* chunk, 
+                                                size_t used, 
+                                                size_t alignment) {
+    const uintptr_t address = (uintptr_t)(chunk->data + used);
+    const uintptr_t aligned = (address + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+
+    return used + (size_t)(aligned - address);
+}
+
+static inline int arena_chunk_fits(const arena_chunk_t* chunk, size_t size, size_t alignment) {
+    const size_t offset = arena_chunk_aligned_offset(chunk, ARENA_LOAD(chunk->used), alignment);
+    return offset <= chunk->size && size <= chunk->size - offset;
+}
+
+/*
+  Bumps the used space of the chunk, returns NULL if the 
+  allocation doesn't fit. In thread safe mode, the new offset 
+  is published with a CAS, because the alignment padding depends 
+  on the offset observed before the bump.
+*/
+static inline void* arena_chunk_bump(arena_chunk_t* chunk, 
+                                     size_t size, 
+                                     size_t alignment, 
+                                     size_t* padding) {
+
+    size_t used = ARENA_LOAD(chunk->used);
+    size_t offset;
+
+    do {
+        offset = arena_chunk_aligned_offset(chunk, used, alignment);
+
+        if(offset > chunk->size || size > chunk->size - offset) {
+            return NULL;
+        }
+    } while(!ARENA_CAS(chunk->used, used, offset + size));
+
+    *padding = offset - used;
+
+    return chunk->data + offset;
+}
+
+#ifdef ARENA_REDUCE_FRAGMENTATION
+
+#ifdef ARENA_THREAD_SAFE
+#error "ARENA_REDUCE_FRAGMENTATION can't be combined with ARENA_THREAD_SAFE!"
+#endif
+
+/*
+  Chunks with less free space than this are considered full,
+  they leave the free space index and are never searched again.
+*/
+#ifndef ARENA_MIN_FREE_SPACE
+#define ARENA_MIN_FREE_SPACE 16
+#endif
+
+#define ARENA_BINS_COUNT 64
+
+#ifndef ARENA_BEST_FIT_MAX_SCAN
+#define ARENA_BEST_FIT_MAX_SCAN 8
+#endif
+
+/*
+  The free space index: the live chunks are kept in segregated bins,
+  the bin `i` holds the chunks with [2^i, 2^(i + 1)) free bytes.
+  The bitmap tracks the non empty bins, so finding the smallest bin
+  able to serve an allocation is a single bit scan.
+
+  The default policy is first fit: only the head of every candidate
+  bin is checked. With ARENA_BEST_FIT defined, the first chunks of the 
+  smallest candidate bin (ARENA_BEST_FIT_MAX_SCAN at most) are scanned 
+  to find the tightest hole, so the lookup stays bounded.
+*/
+typedef struct _arena_free_index {
+    arena_chunk_t* bins[ARENA_BINS_COUNT];
+    uint64_t bitmap;
+} arena_free_index_t;
+
+static inline size_t lowest_bit_index(uint64_t bits) {
+#if defined(__GNUC__)
+    return (size_t)__builtin_ctzll((unsigned long long)bits);
+#else
+    size_t result = 0;
+    while((bits & 1) == 0) { bits >>= 1; result++; }
+    return result;
+#endif
+}
+
+static arena_free_index_t* new_arena_free_index(void) {
+    arena_free_index_t* const index = ARENA_MALLOC(sizeof(arena_free_index_t));
+    ARENA_ASSERT(index != NULL, "Unable to allocate memory!");
+
+    memset(index, 0, sizeof(arena_free_index_t));
+
+    return index;
+}
+
+static void arena_unindex_chunk(arena_t* restrict arena, arena_chunk_t* chunk) {
+
+    arena_free_index_t* const index = arena->free_index;
+
+    if(chunk->bin == ARENA_NO_BIN) {
+        return;
+    }
+
+    if(chunk->bin_prev != NULL) {
+        chunk->bin_prev->bin_next = chunk->bin_next;
+    } else {
+        index->bins[chunk->bin] = chunk->bin_next;
+
+        if(chunk->bin_next == NULL) {
+            index->bitmap &= ~((uint64_t)1 << chunk->bin);
+        }
+    }
+
+    if(chunk->bin_next != NULL) {
+        chunk->bin_next->bin_prev = chunk->bin_prev;
+    }
+
+    chunk->bin = ARENA_NO_BIN;
+}
+
+// Moves the chunk to the bin matching its free space.
+static void arena_index_chunk(arena_t* restrict arena, arena_chunk_t* chunk) {
+
+    arena_free_index_t* const index = arena->free_index;
+
+    const size_t free_space = chunk->size - chunk->used;
+    const size_t bin = (free_space < ARENA_MIN_FREE_SPACE)
+        ? ARENA_NO_BIN
+        : floor_log2(free_space);
+
+    if(bin == chunk->bin) {
+        return;
+    }
+
+    arena_unindex_chunk(arena, chunk);
+
+    if(bin == ARENA_NO_BIN) {
+        return;
+    }
+
+    chunk->bin = bin;
+    chunk->bin_prev = NULL;
+    chunk->bin_next = index->bins[bin];
+
+    if(chunk->bin_next != NULL) {
+        chunk->bin_next->bin_prev = chunk;
+    }
+
+    index->bins[bin] = chunk;
+    index->bitmap |= (uint64_t)1 << bin;
+}
+
+// Drops every chunk from the index.
+static void arena_clear_index(arena_t* restrict arena) {
+
+    for(arena_chunk_t* it = arena->begin; it != NULL; it = it->next) {
+        it->bin = ARENA_NO_BIN;
+    }
+
+    memset(arena->free_index, 0, sizeof(arena_free_index_t));
+}
+
+static arena_chunk_t* arena_find_hole(const arena_t* restrict arena,
+                                      size_t size,
+                                      size_t alignment) {
+
+    const arena_free_index_t* const index = arena->free_index;
+
+    const size_t first_bin = floor_log2(size);
+    uint64_t bins = index->bitmap & (~(uint64_t)0 << first_bin);
+
+#ifdef ARENA_BEST_FIT
+    if(bins & ((uint64_t)1 << first_bin)) {
+        arena_chunk_t* best = NULL;
+        size_t scanned = 0;
+
+        for(arena_chunk_t* it = index->bins[first_bin]; 
+            it != NULL && scanned < ARENA_BEST_FIT_MAX_SCAN; 
+            it = it->bin_next, scanned++) {
+            if(arena_chunk_fits(it, size, alignment) &&
+               (best == NULL || it->size - it->used < best->size - best->used)) {
+                best = it;
+            }
+        }
+
+        if(best != NULL) {
+            return best;
+        }
+
+        bins &= bins - 1;
+    }
+#endif
+
+    // The chunks of the bins above the first one have more than `size` free bytes,
+    // only the alignment padding can make them fail.
+    while(bins != 0) {
+        arena_chunk_t* const chunk = index->bins[lowest_bit_index(bins)];
+
+        if(arena_chunk_fits(chunk, size, alignment)) {
+            return chunk;
+        }
+
+        bins &= bins - 1;
+    }
+
+    return NULL;
+}
+
+#else
+
+static inline void arena_index_chunk(arena_t* restrict arena, arena_chunk_t* chunk) {
+    (void) arena;
+    (void) chunk;
+}
+
+static inline void arena_unindex_chunk(arena_t* restrict arena, arena_chunk_t* chunk) {
+    (void) arena;
+    (void) chunk;
+}
+
+static inline void arena_clear_index(arena_t* restrict arena) {
+    (void) arena;
+}
+
+#endif
+
+#ifdef ARENA_CHECKED
+
+/*
+  Checked mode: every allocation is followed by a redzone of 
+  ARENA_REDZONE_SIZE bytes filled with ARENA_REDZONE_BYTE. 
+  The redzones are recorded in a side table, so arena_validate 
+  can check that no allocation overflowed into the next one.
+*/
+typedef struct {
+    arena_chunk_t* chunk;
+    size_t offset;
+} arena_redzone_t;
+
+typedef struct _arena_redzones {
+    arena_redzone_t* items;
+    size_t count;
+    size_t capacity;
+
+    int lock;
+} arena_redzones_t;
+
+static arena_redzones_t* new_arena_redzones(void) {
+    arena_redzones_t* const redzones = ARENA_MALLOC(sizeof(arena_redzones_t));
+    ARENA_ASSERT(redzones != NULL, "Unable to allocate memory!");
+
+    memset(redzones, 0, sizeof(arena_redzones_t));
+
+    return redzones;
+}
+
+static void delete_arena_redzones(arena_redzones_t* redzones) {
+    ARENA_FREE(redzones->items);
+    ARENA_FREE(redzones);
+}
+
+// The table is guarded by its own lock.
+static void arena_guard_allocation(arena_t* restrict arena, 
+                                   arena_chunk_t* chunk, 
+                                   uint8_t* ptr, 
+                                   size_t size) {
+
+    uint8_t* const redzone = ptr + size;
+
+    ARENA_UNPOISON(ptr, size + ARENA_REDZONE_SIZE);
+    memset(redzone, ARENA_REDZONE_BYTE, ARENA_REDZONE_SIZE);
+    ARENA_POISON(redzone, ARENA_REDZONE_SIZE);
+
+    arena_redzones_t* const redzones = arena->redzones;
+
+    ARENA_LOCK(redzones->lock);
+
+    if(redzones->count == redzones->capacity) {
+        const size_t capacity = (redzones->capacity == 0) ? 64 : redzones->capacity * 2;
+
+        arena_redzone_t* const items = ARENA_MALLOC(sizeof(arena_redzone_t) * capacity);
+        ARENA_ASSERT(items != NULL, "Unable to allocate memory!");
+
+        if(redzones->items != NULL) {
+            memcpy(items, redzones->items, sizeof(arena_redzone_t) * redzones->count);
+            ARENA_FREE(redzones->items);
+        }
+
+        redzones->items = items;
+        redzones->capacity = capacity;
+    }
+
+    redzones->items[redzones->count].chunk = chunk;
+    redzones->items[redzones->count].offset = (size_t)(redzone - chunk->data);
+    redzones->count++;
+
+    ARENA_UNLOCK(redzones->lock);
+}
+
+// Checks the canaries of the redzones from `begin` to the end of the table.
+static int arena_check_redzones_from(const arena_redzones_t* redzones, size_t begin) {
+
+    for(size_t i = begin; i < redzones->count; i++) {
+        uint8_t* const redzone = redzones->items[i].chunk->data + redzones->items[i].offset;
+        int valid = 1;
+
+        ARENA_UNPOISON(redzone, ARENA_REDZONE_SIZE);
+
+        for(size_t j = 0; j < ARENA_REDZONE_SIZE; j++) {
+            if(redzone[j] != ARENA_REDZONE_BYTE) {
+                valid = 0;
+                break;
+            }
+        }
+
+        ARENA_POISON(redzone, ARENA_REDZONE_SIZE);
+
+        if(!valid) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static inline void arena_check_redzones(const arena_t* restrict arena) {
+    ARENA_ASSERT(arena_validate(arena), "Arena redzone overwritten!");
+    (void) arena;
+}
+
+/*
+  The redzones recorded before the mark are below it, a restore 
+  only checks the ones recorded since.
+*/
+static inline void arena_check_mark_redzones(const arena_t* restrict arena, arena_mark_t mark) {
+    ARENA_ASSERT(arena_check_redzones_from(arena->redzones, mark.redzones_count), "Arena redzone overwritten!");
+    (void) arena;
+    (void) mark;
+}
+
+// Drops the redzones of the memory rewound by a restore.
+static void arena_prune_redzones(arena_t* restrict arena, arena_mark_t mark) {
+
+    arena_redzones_t* const redzones = arena->redzones;
+    size_t count = (mark.redzones_count < redzones->count) ? mark.redzones_count : redzones->count;
+
+    for(size_t i = count; i < redzones->count; i++) {
+        const arena_redzone_t* const item = &redzones->items[i];
+
+        if(item->offset + ARENA_REDZONE_SIZE <= item->chunk->used) {
+            redzones->items[count++] = *item;
+        }
+    }
+
+    redzones->count = count;
+}
+
+static inline void arena_clear_redzones(arena_t* restrict arena) {
+    arena->redzones->count = 0;
+}
+
+#else
+
+static inline void arena_check_redzones(const arena_t* restrict arena) {
+    (void) arena;
+}
+
+static inline void arena_check_mark_redzones(const arena_t* restrict arena, arena_mark_t mark) {
+    (void) arena;
+    (void) mark;
+}
+
+static inline void arena_prune_redzones(arena_t* restrict arena, arena_mark_t mark) {
+    (void) arena;
+    (void) mark;
+}
+
+static inline void arena_clear_redzones(arena_t* restrict arena) {
+    (void) arena;
+}
+
+#endif
+
+arena_t create_arena(size_t size) {
+    return create_aligned_arena(size, ARENA_DEFAULT_ALIGNMENT);
+}
+
+static arena_t init_arena(arena_chunk_t* chunk, size_t alignment) {
+    arena_t arena;
+
+    arena.begin = chunk;
+    arena.end = arena.begin;
+    arena.alignment = alignment;
+
+    arena.chunk_size = chunk->size;
+    arena.max_chunk_size = chunk->size;
+
+    arena.max_retained_size = SIZE_MAX;
+
+    arena.chunk_pool = NULL;
+    arena.buffer = NULL;
+
+    arena.parent = NULL;
+    arena.parent_mark.chunk = NULL;
+    arena.parent_mark.last = NULL;
+    arena.parent_mark.used = 0;
+    arena.parent_mark.redzones_count = 0;
+    arena.parent_used = 0;
+    arena.children_count = 0;
+    arena.children_mark.chunk = NULL;
+    arena.children_mark.last = NULL;
+    arena.children_mark.used = 0;
+    arena.children_mark.redzones_count = 0;
+    arena.children_used = 0;
+
+    memset(&arena.stats, 0, sizeof(arena_stats_t));
+    arena.stats.chunks_count = 1;
+    arena.stats.capacity = chunk->size;
+
+    arena.hooks = NULL;
+
+    arena.directory = NULL;
+
+#ifdef ARENA_SNAPSHOT
+    arena.image_size = PAGE_SIZE;
+#endif
+    arena_place_chunk(&arena, chunk);
+
+#ifdef ARENA_REDUCE_FRAGMENTATION
+    arena.free_index = new_arena_free_index();
+    arena_index_chunk(&arena, chunk);
+#else
+    arena.free_index = NULL;
+#endif
+
+#ifdef ARENA_CHECKED
+    arena.redzones = new_arena_redzones();
+#else
+    arena.redzones = NULL;
+#endif
+
+    arena.spare = NULL;
+    arena.prefaulter = NULL;
+
+    ARENA_POISON(chunk->data, chunk->size);
+
+    return arena;
+}
+
+#ifdef ARENA_CHUNK_POOL
+
+static arena_t arena_chunk_pool_init_arena(arena_chunk_pool_t* pool, size_t size, size_t alignment) {
+
+    size = round_to_power_of_two(size);
+
+    arena_chunk_t* chunk = arena_chunk_pool_pop(pool, size);
+    const int pooled = chunk != NULL;
+
+    if(!pooled) {
+        chunk = new_arena_chunk(size);
+    }
+
+    arena_t arena = init_arena(chunk, alignment);
+    arena.chunk_pool = pool;
+    arena.stats.malloc_calls = pooled ? 0 : 1;
+
+    return arena;
+}
+
+#endif
+
+#ifdef ARENA_CHUNK_POOL_GLOBAL
+
+#ifndef ARENA_CHUNK_POOL_GLOBAL_MAX_SIZE
+#define ARENA_CHUNK_POOL_GLOBAL_MAX_SIZE ((size_t)64 << 20)
+#endif
+
+// With ARENA_CHUNK_POOL_GLOBAL, every arena created by create_arena is pooled.
+static arena_chunk_pool_t arena_chunk_pool_global = { { { NULL, 0 } }, 0, 0, ARENA_CHUNK_POOL_GLOBAL_MAX_SIZE, 0, NULL };
+
+inline arena_chunk_pool_t* arena_chunk_pool_get_global(void) {
+    return &arena_chunk_pool_global;
+}
+
+#endif
+
+arena_t create_aligned_arena(size_t size, size_t alignment) {
+    ARENA_ASSERT(is_power_of_two(alignment), "Alignment must be a power of two!");
+
+#ifdef ARENA_CHUNK_POOL_GLOBAL
+    return arena_chunk_pool_init_arena(&arena_chunk_pool_global, size, alignment);
+#else
+    arena_t arena = init_arena(new_arena_chunk(size), alignment);
+    arena.stats.malloc_calls = 1;
+
+    return arena;
+#endif
+}
+
+#ifdef ARENA_CHUNK_POOL
+
+arena_chunk_pool_t create_arena_chunk_pool(size_t chunk_size) {
+    arena_chunk_pool_t pool;
+
+    memset(pool.buckets, 0, sizeof(pool.buckets));
+    pool.chunk_size = chunk_size;
+
+    pool.size = 0;
+    pool.max_size = SIZE_MAX;
+
+    pool.poppers = 0;
+    pool.retired = NULL;
+
+    return pool;
+}
+
+inline void destroy_arena_chunk_pool(arena_chunk_pool_t* restrict pool) {
+    arena_chunk_pool_trim(pool, 0);
+}
+
+void arena_chunk_pool_set_max_size(arena_chunk_pool_t* restrict pool, size_t max_size) {
+    pool->max_size = max_size;
+    arena_chunk_pool_trim(pool, max_size);
+}
+
+/*
+  Frees the pooled chunks until the pool holds at most `max_size` 
+  bytes, the largest chunks first. It can run concurrently with 
+  the arenas using the pool, the chunks that pops in progress may 
+  still read are left retired.
+*/
+void arena_chunk_pool_trim(arena_chunk_pool_t* restrict pool, size_t max_size) {
+
+    arena_chunk_t* trimmed = NULL;
+
+    for(size_t i = ARENA_CHUNK_POOL_BUCKETS_COUNT; i-- > 0;) {
+        arena_chunk_t* chunk;
+
+        while(ARENA_ATOMIC_LOAD(pool->size) > max_size && 
+              (chunk = arena_chunk_pool_pop_bucket(pool, &pool->buckets[i])) != NULL) {
+
+            (void) ARENA_ATOMIC_SUB(pool->size, chunk->size);
+
+            ARENA_ATOMIC_STORE(chunk->next, trimmed);
+            trimmed = chunk;
+        }
+    }
+
+    if(trimmed != NULL) {
+        arena_chunk_pool_retire(pool, trimmed);
+    }
+
+    arena_chunk_pool_collect(pool);
+}
+
+arena_t arena_chunk_pool_create_arena(arena_chunk_pool_t* pool) {
+    return arena_chunk_pool_init_arena(pool, pool->chunk_size, ARENA_DEFAULT_ALIGNMENT);
+}
+
+#endif
+
+/*
+  The first chunk lives in `buffer`, its header included, so an arena 
+  that never outgrows the buffer doesn't allocate at all. When the 
+  buffer is full, the arena spills to heap chunks of at least a page.
+*/
+void arena_init_with_buffer(arena_t* restrict arena, void* buffer, size_t size) {
+
+    arena_chunk_t* const chunk = arena_chunk_from_buffer(buffer, size);
+
+    *arena = init_arena(chunk, ARENA_DEFAULT_ALIGNMENT);
+    arena->buffer = chunk;
+
+    if(arena->chunk_size < PAGE_SIZE) {
+        arena->chunk_size = PAGE_SIZE;
+        arena->max_chunk_size = PAGE_SIZE;
+    }
+
+#ifdef ARENA_CHUNK_POOL_GLOBAL
+    arena->chunk_pool = &arena_chunk_pool_global;
+#endif
+}
+
+/*
+  The chunks of the child are carved out of the parent, they're 
+  released with the parent. Destroying the child rolls the parent 
+  back to its state before the child, unless the parent has been 
+  used in the meantime. The chunks of the children destroyed out 
+  of order are given back with the last child. The parent can't be 
+  reset or destroyed while it has children.
+*/
+arena_t create_child_arena(arena_t* parent, size_t size) {
+
+    const arena_mark_t mark = arena_save(parent);
+    const size_t used = arena_used_space(parent);
+
+    if(ARENA_COUNTER(parent->children_count) == 0) {
+        parent->children_mark = mark;
+        ARENA_STORE(parent->children_used, used);
+    }
+
+    arena_chunk_t* const chunk = arena_carve_chunk(parent, size);
+    arena_track_children(parent, used, arena_used_space(parent));
+
+    arena_t arena = init_arena(chunk, parent->alignment);
+
+    arena.parent = parent;
+    arena.parent_mark = mark;
+    arena.parent_used = arena_used_space(parent);
+
+    (void) ARENA_ADD(parent->children_count, 1);
+
+    return arena;
+}
+
+void arena_set_max_chunk_size(arena_t* restrict arena, size_t max_chunk_size) {
+    arena->max_chunk_size = max_chunk_size;
+}
+
+void arena_set_max_retained_size(arena_t* restrict arena, size_t max_retained_size) {
+    arena->max_retained_size = max_retained_size;
+}
+
+arena_stats_t arena_get_stats(const arena_t* restrict arena) {
+    arena_stats_t stats;
+
+    stats.requested = ARENA_COUNTER(arena->stats.requested);
+    stats.padding = ARENA_COUNTER(arena->stats.padding);
+    stats.wasted = ARENA_COUNTER(arena->stats.wasted);
+    stats.used = arena_used_space(arena);
+    stats.peak_used = ARENA_COUNTER(arena->stats.peak_used);
+    stats.chunks_count = ARENA_COUNTER(arena->stats.chunks_count);
+    stats.capacity = ARENA_COUNTER(arena->stats.capacity);
+    stats.malloc_calls = ARENA_COUNTER(arena->stats.malloc_calls);
+
+    return stats;
+}
+
+/*
+  Returns the chunk at `chunk_index` in the chunks list, 
+  or NULL if the index is out of bounds.
+*/
+const arena_chunk_t* arena_get_chunk(const arena_t* restrict arena, size_t chunk_index) {
+
+    arena_directory_t* const directory = ARENA_LOAD(arena->directory);
+    const arena_chunk_t* chunk = NULL;
+
+    if(directory == NULL) {
+        return (chunk_index == 0) ? arena->begin : NULL;
+    }
+
+    ARENA_LOCK(directory->lock);
+
+    if(chunk_index < directory->size) {
+        chunk = directory->chunks[chunk_index];
+    }
+
+    ARENA_UNLOCK(directory->lock);
+
+    return chunk;
+}
+
+/*
+  The hooks are called on the thread that acquires or releases 
+  the chunk. The structure isn't copied, it must outlive the arena.
+  The chunks already in the arena are released from the previous 
+  hooks and acquired by the new ones, so the calls stay balanced.
+*/
+void arena_set_hooks(arena_t* restrict arena, const arena_hooks_t* hooks) {
+
+    const arena_hooks_t* const previous = arena->hooks;
+
+    for(const arena_chunk_t* it = arena->begin; it != NULL; it = ARENA_LOAD(it->next)) {
+        if(previous != NULL && previous->chunk_released != NULL) {
+            previous->chunk_released(previous->user_data, it);
+        }
+
+        if(hooks != NULL && hooks->chunk_acquired != NULL) {
+            hooks->chunk_acquired(hooks->user_data, it);
+        }
+    }
+
+    arena->hooks = hooks;
+}
+
+/*
+  Finds a chunk past `current` (the end observed by the caller) able 
+  to serve an allocation of `size` bytes. Virtual memory chunks grow 
+  in place first, then the chunks retained by a reset are reused, 
+  otherwise a new chunk is inserted after the chunks in use. Regular 
+  chunks grow geometrically up to `max_chunk_size` and become the new 
+  end. Requests that don't fit a regular chunk get a dedicated one 
+  sized to fit, linked behind the end without moving it, so that the 
+  free tail of the current chunk keeps serving small allocations.
+
+  In thread safe mode, the chunk is installed with a CAS, without a 
+  lock: the losers free their chunk and retry with the chunk installed 
+  by the winner. Only the directory update takes the directory lock. 
+  A caller whose `current` is stale (the end already moved past it) 
+  retries on the new end, it never inserts a chunk behind the end.
+  It returns NULL if no chunk can be that large.
+*/
+static arena_chunk_t* arena_push_chunk(arena_t* restrict arena, 
+                                       arena_chunk_t* current,
+                                       size_t size, 
+                                       size_t alignment) {
+
+    const size_t slack = (alignment > ARENA_CHUNK_ALIGNMENT) ? alignment - ARENA_CHUNK_ALIGNMENT : 0;
+
+    if(size > ARENA_MAX_ALLOCATION_SIZE || slack > ARENA_MAX_ALLOCATION_SIZE - size) {
+        return NULL;
+    }
+
+    arena_chunk_t* const end = ARENA_LOAD(arena->end);
+
+    if(current != end) {
+        return end;
+    }
+
+    const size_t required_used = 
+        arena_chunk_aligned_offset(current, ARENA_LOAD(current->used), alignment) + size;
+
+    if(arena_chunk_commit(arena, current, required_used)) {
+        return current;
+    }
+
+    const size_t required_size = size + slack;
+    const size_t chunk_size = arena_next_chunk_size(arena);
+
+    // A regular chunk, or a dedicated one for a large request.
+    const int regular = required_size <= chunk_size;
+
+    // The dedicated chunks in use sit right after the end, skip them.
+    arena_chunk_t* last = current;
+    arena_chunk_t* next = ARENA_LOAD(current->next);
+
+    while(next != NULL && ARENA_LOAD(next->used) != 0) {
+        last = next;
+        next = ARENA_LOAD(next->next);
+    }
+
+    if(next != NULL && arena_chunk_fits(next, size, alignment)) {
+        if(regular && ARENA_CAS(arena->end, current, next)) {
+            (void) ARENA_ADD(arena->stats.wasted, current->size - ARENA_LOAD(current->used));
+        }
+
+        return next;
+    }
+
+    arena_chunk_t* const chunk = arena_acquire_chunk(arena, regular ? chunk_size : required_size);
+
+    /*
+      The links are written atomically even in single threaded mode: a 
+      chunk taken from a chunk pool can still have its link read by the 
+      stale pops of other threads (see arena_chunk_pool_pop_bucket).
+    */
+    ARENA_ATOMIC_STORE(chunk->next, next);
+
+    if(!ARENA_ATOMIC_CAS(last->next, next, chunk)) {
+        arena_release_chunk(arena, chunk);
+        return current;
+    }
+
+    arena_directory_insert(arena, last);
+
+    arena_attach_chunk(arena, chunk);
+
+    if(regular) {
+        ARENA_STORE(arena->chunk_size, chunk_size);
+
+        if(ARENA_CAS(arena->end, current, chunk)) {
+            (void) ARENA_ADD(arena->stats.wasted, current->size - ARENA_LOAD(current->used));
+        }
+    }
+
+    return chunk;
+}
+
+#ifdef ARENA_PREFAULT
+
+/*
+  Prepares a spare chunk for the next regular chunk of the arena, with 
+  its pages faulted in, so that moving to a new chunk doesn't call 
+  malloc nor page faults. A spare large enough is kept, an undersized 
+  one (the chunk size grew since it was prepared) is replaced.
+*/
+void arena_prefault(arena_t* restrict arena) {
+
+    const size_t size = arena_next_chunk_size(arena);
+    arena_chunk_t* chunk = arena_take_spare(arena, size);
+
+    if(chunk == NULL) {
+        chunk = arena_allocate_chunk(arena, size);
+        arena_chunk_prefault(chunk);
+    }
+
+    // In thread safe mode, another thread could have installed a spare.
+    arena_chunk_t* spare = NULL;
+
+    if(!ARENA_CAS(arena->spare, spare, chunk)) {
+        arena_release_chunk(arena, chunk);
+    }
+}
+
+#endif
+
+#ifdef ARENA_PREFAULT_THREAD
+
+#ifndef ARENA_THREAD_SAFE
+#error "ARENA_PREFAULT_THREAD requires ARENA_THREAD_SAFE!"
+#endif
+
+#include <pthread.h>
+
+// The spare chunk is refilled when the end chunk is this full (in percent).
+#ifndef ARENA_PREFAULT_THRESHOLD
+#define ARENA_PREFAULT_THRESHOLD 75
+#endif
+
+/*
+  The background thread sleeps until an allocation crosses the 
+  threshold of the end chunk while there's no spare, `pending` 
+  makes sure it's woken up once per spare.
+*/
+typedef struct _arena_prefaulter {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+
+    int pending;
+    int stopping;
+} arena_prefaulter_t;
+
+static void* arena_prefault_thread(void* arg) {
+
+    arena_t* const arena = (arena_t*)arg;
+    arena_prefaulter_t* const prefaulter = arena->prefaulter;
+
+    pthread_mutex_lock(&prefaulter->lock);
+
+    while(!prefaulter->stopping) {
+        if(!ARENA_ATOMIC_LOAD(prefaulter->pending)) {
+            pthread_cond_wait(&prefaulter->wake, &prefaulter->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&prefaulter->lock);
+
+        arena_prefault(arena);
+        ARENA_ATOMIC_STORE(prefaulter->pending, 0);
+
+        pthread_mutex_lock(&prefaulter->lock);
+    }
+
+    pthread_mutex_unlock(&prefaulter->lock);
+
+    return NULL;
+}
+
+void arena_start_prefault_thread(arena_t* restrict arena) {
+
+    ARENA_ASSERT(arena->prefaulter == NULL, "The prefault thread is already running!");
+
+    arena_prefaulter_t* const prefaulter = ARENA_MALLOC(sizeof(arena_prefaulter_t));
+    ARENA_ASSERT(prefaulter != NULL, "Unable to allocate memory!");
+
+    pthread_mutex_init(&prefaulter->lock, NULL);
+    pthread_cond_init(&prefaulter->wake, NULL);
+    prefaulter->pending = 0;
+    prefaulter->stopping = 0;
+
+    arena->prefaulter = prefaulter;
+
+    const int result = pthread_create(&prefaulter->thread, NULL, arena_prefault_thread, arena);
+    ARENA_ASSERT(result == 0, "Unable to start the prefault thread!");
+    (void) result;
+}
+
+void arena_stop_prefault_thread(arena_t* restrict arena) {
+
+    arena_prefaulter_t* const prefaulter = arena->prefaulter;
+
+    if(prefaulter == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&prefaulter->lock);
+    prefaulter->stopping = 1;
+    pthread_cond_signal(&prefaulter->wake);
+    pthread_mutex_unlock(&prefaulter->lock);
+
+    pthread_join(prefaulter->thread, NULL);
+
+    pthread_cond_destroy(&prefaulter->wake);
+    pthread_mutex_destroy(&prefaulter->lock);
+    ARENA_FREE(prefaulter);
+
+    arena->prefaulter = NULL;
+}
+
+static inline void arena_check_prefault(arena_t* restrict arena, const arena_chunk_t* chunk) {
+
+    arena_prefaulter_t* const prefaulter = arena->prefaulter;
+
+    if(prefaulter == NULL || 
+       ARENA_LOAD(chunk->used) < ARENA_LOAD(chunk->size) / 100 * ARENA_PREFAULT_THRESHOLD ||
+       ARENA_LOAD(chunk->next) != NULL || ARENA_LOAD(arena->spare) != NULL) {
+        return;
+    }
+
+    if(!ARENA_ATOMIC_EXCHANGE(prefaulter->pending, 1)) {
+        pthread_mutex_lock(&prefaulter->lock);
+        pthread_cond_signal(&prefaulter->wake);
+        pthread_mutex_unlock(&prefaulter->lock);
+    }
+}
+
+#endif
+
+inline void* arena_alloc(arena_t* restrict arena, size_t size) {
+    return arena_alloc_aligned(arena, size, arena->alignment);
+}
+
+static inline void arena_count_allocation(arena_t* restrict arena, size_t size, size_t padding) {
+
+#ifdef ARENA_ALLOCATION_STATS
+    (void) ARENA_ADD(arena->stats.requested, size);
+    (void) ARENA_ADD(arena->stats.padding, padding);
+
+    const size_t used = ARENA_ADD(arena->stats.used, size + padding);
+    size_t peak_used = ARENA_COUNTER(arena->stats.peak_used);
+
+#ifdef ARENA_THREAD_SAFE
+    while(used > peak_used && 
+          !__atomic_compare_exchange_n(&arena->stats.peak_used, &peak_used, used, 1, 
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#else
+    if(used > peak_used) {
+        arena->stats.peak_used = used;
+    }
+#endif
+#else
+    (void) arena;
+    (void) size;
+    (void) padding;
+#endif
+}
+
+static inline void arena_count_release(arena_t* restrict arena, size_t size) {
+
+#ifdef ARENA_ALLOCATION_STATS
+    (void) ARENA_SUB(arena->stats.used, size);
+#else
+    (void) arena;
+    (void) size;
+#endif
+}
+
+/*
+  Allocates `size` bytes and returns the chunk serving the 
+  allocation in `chunk`.
+*/
+static inline void* arena_bump_alloc(arena_t* restrict arena, 
+                                     size_t size, 
+                                     size_t alignment, 
+                                     arena_chunk_t** chunk) {
+
+#ifdef ARENA_CHECKED
+    if(size > SIZE_MAX - ARENA_REDZONE_SIZE) {
+        return NULL;
+    }
+
+    const size_t bumped_size = size + ARENA_REDZONE_SIZE;
+
+#ifdef ARENA_ASAN
+    // Two allocations never share a shadow granule, so their poisoning can't race.
+    if(alignment < ARENA_ASAN_GRANULARITY) {
+        alignment = ARENA_ASAN_GRANULARITY;
+    }
+#endif
+#else
+    const size_t bumped_size = size;
+#endif
+
+#ifdef ARENA_REDUCE_FRAGMENTATION
+
+    /*
+      With this, we'll reduce internal fragmentation by searching 
+      for "holes" not big enough for previous allocations but large 
+      enough for the current one.
+    */
+
+    arena_chunk_t* current = arena_find_hole(arena, bumped_size, alignment);
+
+    if(current == NULL) {
+        current = arena->end;
+    }
+#else
+
+    arena_chunk_t* current = ARENA_LOAD(arena->end);
+
+#endif
+
+    void* ptr;
+    size_t padding;
+
+    while((ptr = arena_chunk_bump(current, bumped_size, alignment, &padding)) == NULL) {
+        current = arena_push_chunk(arena, current, bumped_size, alignment);
+
+        if(current == NULL) {
+            return NULL;
+        }
+    }
+
+    arena_index_chunk(arena, current);
+
+#ifdef ARENA_CHECKED
+    arena_guard_allocation(arena, current, (uint8_t*)ptr, size);
+#endif
+
+    // The redzone is accounted as padding.
+    arena_count_allocation(arena, size, padding + (bumped_size - size));
+
+#ifdef ARENA_PREFAULT_THREAD
+    arena_check_prefault(arena, current);
+#endif
+
+    *chunk = current;
+
+    return ptr;
+}
+
+void* arena_alloc_aligned(arena_t* restrict arena, size_t size, size_t alignment) {
+
+    if(size <= 0) return NULL;
+
+    ARENA_ASSERT(is_power_of_two(alignment), "Alignment must be a power of two!");
+
+    arena_chunk_t* chunk;
+
+    return arena_bump_alloc(arena, size, alignment, &chunk);
+}
+
+void* arena_alloc_array(arena_t* restrict arena, 
+                        size_t count, 
+                        size_t size, 
+                        size_t alignment) {
+
+    if(size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+
+    return arena_alloc_aligned(arena, count * size, alignment);
+}
+
+/*
+  The objects are carved out of a single block, every object 
+  starts at a multiple of `size` rounded up to the alignment.
+*/
+void* arena_alloc_batch(arena_t* restrict arena, 
+                        void** restrict ptrs, 
+                        size_t count, 
+                        size_t size, 
+                        size_t alignment) {
+
+    ARENA_ASSERT(is_power_of_two(alignment), "Alignment must be a power of two!");
+
+    if(size > SIZE_MAX - (alignment - 1)) {
+        return NULL;
+    }
+
+    const size_t stride = (size + alignment - 1) & ~(alignment - 1);
+    uint8_t* const block = (uint8_t*)arena_alloc_array(arena, count, stride, alignment);
+
+    if(block == NULL) {
+        return NULL;
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        ptrs[i] = block + i * stride;
+    }
+
+    return block;
+}
+
+/*
+  Only the bytes below the dirty watermark of the chunk are cleared, 
+  the memory above it was never handed out since the chunk was 
+  mapped (or calloc'd, see ARENA_CALLOC) or released to the system.
+*/
+void* arena_calloc(arena_t* restrict arena, size_t count, size_t size) {
+
+    if(size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+
+    const size_t total_size = count * size;
+
+    if(total_size == 0) {
+        return NULL;
+    }
+
+    arena_chunk_t* chunk;
+    uint8_t* const ptr = (uint8_t*)arena_bump_alloc(arena, total_size, arena->alignment, &chunk);
+
+    if(ptr == NULL) {
+        return NULL;
+    }
+
+    const size_t offset = (size_t)(ptr - chunk->data);
+    const size_t dirty = chunk->dirty;
+
+    if(offset < dirty) {
+        memset(ptr, 0, (dirty - offset < total_size) ? dirty - offset : total_size);
+    }
+
+    return ptr;
+}
+
+void* arena_realloc(arena_t* restrict arena, 
+                    const void* restrict ptr, 
+                    size_t old_size, 
+                    size_t new_size) {
+    
+    if(new_size <= 0) {
+        return NULL;
+    }
+
+    if(ptr == NULL) {
+        return arena_alloc(arena, new_size);
+    }
+
+    arena_chunk_t* const current = arena->end;
+
+    // The most recent allocation can grow or shrink in place.
+    if((const uint8_t*)ptr + old_size == current->data + current->used) {
+        const size_t offset = current->used - old_size;
+
+        if(new_size <= current->size - offset || 
+           (new_size <= ARENA_MAX_ALLOCATION_SIZE && arena_chunk_commit(arena, current, offset + new_size))) {
+
+            if(new_size > old_size) {
+                arena_count_allocation(arena, new_size - old_size, 0);
+            } else {
+                arena_count_release(arena, old_size - new_size);
+            }
+
+            arena_chunk_rewind(current, offset + new_size);
+            arena_index_chunk(arena, current);
+
+            return (void*)ptr;
+        }
+    }
+
+    if(new_size <= old_size) {
+        return (void*)ptr;
+    }
+
+    void* new_ptr = arena_alloc(arena, new_size);
+
+    if(new_ptr != NULL) {
+        memcpy(new_ptr, ptr, old_size);
+    }
+
+    return new_ptr;
+}
+
+/*
+  Gives the most recent allocation back to the current chunk, 
+  it does nothing if `ptr` isn't the last block of the chunk.
+*/
+void arena_free_last(arena_t* restrict arena, const void* restrict ptr, size_t size) {
+
+    arena_chunk_t* const current = arena->end;
+
+    if(ptr == NULL || size > current->used || 
+       (const uint8_t*)ptr + size != current->data + current->used) {
+        return;
+    }
+
+    arena_count_release(arena, size);
+
+    arena_chunk_rewind(current, current->used - size);
+    arena_index_chunk(arena, current);
+}
+
+inline char* arena_strdup(arena_t* restrict arena, 
+                          const char* restrict str) {
+    return arena_strndup(arena, str, strlen(str));
+}
+
+char* arena_strndup(arena_t* restrict arena, 
+                    const char* restrict str, 
+                    size_t length) {
+
+    // Strings only need byte alignment, keep them tightly packed.
+    char* const new_str = (char*)arena_alloc_aligned(arena, sizeof(char) * length + 1, 1);
+
+    memcpy(new_str, str, sizeof(char) * length);
+    new_str[length] = '\0';
+
+    return new_str;
+}
+
+/*
+  Grows a buffer of `*capacity` elements so that it holds at least 
+  `required` elements. The capacity doubles, so a buffer that isn't 
+  at the tail of the arena anymore is relocated a logarithmic number 
+  of times, while a buffer at the tail grows in place.
+*/
+static void* arena_grow_buffer(arena_t* restrict arena, 
+                               void* data, 
+                               size_t* capacity, 
+                               size_t required, 
+                               size_t element_size) {
+
+    if(required <= *capacity) {
+        return data;
+    }
+
+    size_t new_capacity = (*capacity < 8) ? 8 : *capacity;
+
+    while(new_capacity < required) {
+        ARENA_ASSERT(new_capacity <= SIZE_MAX / 2, "Buffer size overflow!");
+        new_capacity *= 2;
+    }
+
+    ARENA_ASSERT(new_capacity <= SIZE_MAX / element_size, "Buffer size overflow!");
+
+    data = arena_realloc(arena, data, *capacity * element_size, new_capacity * element_size);
+    *capacity = new_capacity;
+
+    return data;
+}
+
+arena_vec_t create_arena_vec(arena_t* arena, size_t element_size) {
+    arena_vec_t vec;
+
+    vec.arena = arena;
+    vec.data = NULL;
+    vec.length = 0;
+    vec.capacity = 0;
+    vec.element_size = element_size;
+
+    return vec;
+}
+
+inline void* arena_vec_push(arena_vec_t* restrict vec, const void* restrict element) {
+    return arena_vec_push_n(vec, element, 1);
+}
+
+void* arena_vec_push_n(arena_vec_t* restrict vec, 
+                       const void* restrict elements, 
+                       size_t count) {
+
+    ARENA_ASSERT(count <= SIZE_MAX - vec->length, "Buffer size overflow!");
+
+    vec->data = arena_grow_buffer(vec->arena, vec->data, &vec->capacity, 
+                                  vec->length + count, vec->element_size);
+
+    uint8_t* const slot = (uint8_t*)vec->data + vec->length * vec->element_size;
+
+    if(elements != NULL) {
+        memcpy(slot, elements, count * vec->element_size);
+    }
+
+    vec->length += count;
+
+    return slot;
+}
+
+void arena_vec_reserve(arena_vec_t* restrict vec, size_t capacity) {
+    vec->data = arena_grow_buffer(vec->arena, vec->data, &vec->capacity, 
+                                  capacity, vec->element_size);
+}
+
+/*
+  Gives back the unused capacity (if the vector is the most recent
+  allocation) and detaches the elements from the vector.
+*/
+void* arena_vec_finalize(arena_vec_t* restrict vec) {
+
+    void* data = vec->data;
+
+    if(data != NULL && vec->length > 0) {
+        data = arena_realloc(vec->arena, data, 
+                             vec->capacity * vec->element_size, 
+                             vec->length * vec->element_size);
+    }
+
+    vec->data = NULL;
+    vec->length = 0;
+    vec->capacity = 0;
+
+    return data;
+}
+
+arena_strbuf_t create_arena_strbuf(arena_t* arena) {
+    arena_strbuf_t strbuf;
+
+    strbuf.arena = arena;
+    strbuf.data = NULL;
+    strbuf.length = 0;
+    strbuf.capacity = 0;
+
+    return strbuf;
+}
+
+inline void arena_strbuf_append(arena_strbuf_t* restrict strbuf, const char* restrict str) {
+    arena_strbuf_appendn(strbuf, str, strlen(str));
+}
+
+void arena_strbuf_appendn(arena_strbuf_t* restrict strbuf, 
+                          const char* restrict str, 
+                          size_t length) {
+
+    ARENA_ASSERT(length < SIZE_MAX - strbuf->length, "Buffer size overflow!");
+
+    // One more byte for the null terminator.
+    strbuf->data = (char*)arena_grow_buffer(strbuf->arena, strbuf->data, &strbuf->capacity, 
+                                            strbuf->length + length + 1, sizeof(char));
+
+    memcpy(strbuf->data + strbuf->length, str, length);
+
+    strbuf->length += length;
+    strbuf->data[strbuf->length] = '\0';
+}
+
+void arena_strbuf_appendf(arena_strbuf_t* restrict strbuf, const char* restrict format, ...) {
+
+    va_list args;
+    va_list args_copy;
+
+    va_start(args, format);
+    va_copy(args_copy, args);
+
+    // The formatted string is written in place when it fits the free capacity.
+    const size_t available = strbuf->capacity - strbuf->length;
+    const int length = vsnprintf(strbuf->data ? strbuf->data + strbuf->length : NULL, 
+                                 available, format, args);
+
+    va_end(args);
+
+    ARENA_ASSERT(length >= 0, "Invalid format string!");
+
+    if((size_t)length >= available) {
+        strbuf->data = (char*)arena_grow_buffer(strbuf->arena, strbuf->data, &strbuf->capacity, 
+                                                strbuf->length + (size_t)length + 1, sizeof(char));
+
+        vsnprintf(strbuf->data + strbuf->length, (size_t)length + 1, format, args_copy);
+    }
+
+    va_end(args_copy);
+
+    strbuf->length += (size_t)length;
+}
+
+/*
+  Returns the built string, trimmed to its length, and empties 
+  the string builder.
+*/
+char* arena_strbuf_finalize(arena_strbuf_t* restrict strbuf) {
+
+    char* str;
+
+    if(strbuf->data == NULL) {
+        str = arena_strndup(strbuf->arena, "", 0);
+    } else {
+        str = (char*)arena_realloc(strbuf->arena, strbuf->data, 
+                                   strbuf->capacity, strbuf->length + 1);
+    }
+
+    strbuf->data = NULL;
+    strbuf->length = 0;
+    strbuf->capacity = 0;
+
+    return str;
+}
+
+// 64 bit FNV-1a, the zero hash marks the empty slots of a map.
+static inline uint64_t arena_hash(const void* key, size_t key_length) {
+
+    const uint8_t* const bytes = (const uint8_t*)key;
+    uint64_t hash = 14695981039346656037ULL;
+
+    for(size_t i = 0; i < key_length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return (hash == 0) ? 1 : hash;
+}
+
+/*
+  Linear probing: returns the slot holding the key, or the empty 
+  slot where the key belongs. The hashes are kept apart from the 
+  entries, so a probe sequence scans a single cache line most of 
+  the time, and the keys are only compared on a full hash match.
+*/
+static size_t arena_map_find_slot(const arena_map_t* restrict map, 
+                                  uint64_t hash, 
+                                  const void* key, 
+                                  size_t key_length) {
+
+    const size_t mask = map->capacity - 1;
+    size_t slot = (size_t)hash & mask;
+
+    while(map->hashes[slot] != 0) {
+        const arena_map_entry_t* const entry = &map->entries[slot];
+
+        if(map->hashes[slot] == hash && entry->key_length == key_length && 
+           memcmp(entry->key, key, key_length) == 0) {
+            break;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+/*
+  The old arrays aren't freed, they stay in the arena until 
+  it's reset. The stored hashes avoid hashing the keys again.
+*/
+static void arena_map_resize(arena_map_t* restrict map, size_t capacity) {
+
+    arena_map_t resized = *map;
+
+    resized.capacity = capacity;
+    resized.hashes = (uint64_t*)arena_calloc(map->arena, capacity, sizeof(uint64_t));
+    resized.entries = ARENA_NEW(map->arena, arena_map_entry_t, capacity);
+
+    for(size_t i = 0; i < map->capacity; i++) {
+        if(map->hashes[i] == 0) {
+            continue;
+        }
+
+        const arena_map_entry_t* const entry = &map->entries[i];
+        const size_t slot = arena_map_find_slot(&resized, map->hashes[i], 
+                                                entry->key, entry->key_length);
+
+        resized.hashes[slot] = map->hashes[i];
+        resized.entries[slot] = *entry;
+    }
+
+    *map = resized;
+}
+
+arena_map_t create_arena_map(arena_t* arena, size_t capacity) {
+    arena_map_t map;
+
+    map.arena = arena;
+    map.hashes = NULL;
+    map.entries = NULL;
+    map.count = 0;
+    map.capacity = 0;
+
+    if(capacity > 0) {
+        size_t slots = 16;
+
+        // Room for `capacity` keys below the maximum load factor (3/4).
+        while(slots / 4 * 3 < capacity) {
+            slots *= 2;
+        }
+
+        arena_map_resize(&map, slots);
+    }
+
+    return map;
+}
+
+void* arena_map_get(const arena_map_t* restrict map, const void* key, size_t key_length) {
+
+    if(map->count == 0) {
+        return NULL;
+    }
+
+    const uint64_t hash = arena_hash(key, key_length);
+    const size_t slot = arena_map_find_slot(map, hash, key, key_length);
+
+    return (map->hashes[slot] != 0) ? map->entries[slot].value : NULL;
+}
+
+/*
+  Returns the entry of the key, inserting it if it's missing 
+  (`inserted` is set to 1 in this case). The key memory isn't 
+  copied, it must outlive the map.
+*/
+static arena_map_entry_t* arena_map_insert(arena_map_t* restrict map, 
+                                           const void* key, 
+                                           size_t key_length,
+                                           int* inserted) {
+
+    if(map->count + 1 > map->capacity / 4 * 3) {
+        arena_map_resize(map, (map->capacity == 0) ? 16 : map->capacity * 2);
+    }
+
+    const uint64_t hash = arena_hash(key, key_length);
+    const size_t slot = arena_map_find_slot(map, hash, key, key_length);
+
+    arena_map_entry_t* const entry = &map->entries[slot];
+    *inserted = map->hashes[slot] == 0;
+
+    if(*inserted) {
+        map->hashes[slot] = hash;
+        map->count++;
+
+        entry->key = key;
+        entry->key_length = key_length;
+        entry->value = NULL;
+    }
+
+    return entry;
+}
+
+void arena_map_put(arena_map_t* restrict map, const void* key, size_t key_length, void* value) {
+    int inserted;
+    arena_map_insert(map, key, key_length, &inserted)->value = value;
+}
+
+arena_interner_t create_arena_interner(arena_t* arena) {
+    arena_interner_t interner;
+
+    interner.map = create_arena_map(arena, 0);
+    interner.strings = create_arena_vec(arena, sizeof(const char*));
+
+    return interner;
+}
+
+/*
+  Every distinct string is copied once, with arena_strndup. The ids 
+  are the indices of the strings in insertion order, stored as the 
+  values of the map whose keys are the copies themselves.
+*/
+size_t arena_intern_id(arena_interner_t* restrict interner, 
+                       const char* restrict str, 
+                       size_t length) {
+
+    int inserted;
+    arena_map_entry_t* const entry = arena_map_insert(&interner->map, str, length, &inserted);
+
+    if(inserted) {
+        const char* const copy = arena_strndup(interner->map.arena, str, length);
+
+        entry->key = copy;
+        entry->value = (void*)(uintptr_t)interner->strings.length;
+
+        arena_vec_push(&interner->strings, &copy);
+    }
+
+    return (size_t)(uintptr_t)entry->value;
+}
+
+inline const char* arena_interned_string(const arena_interner_t* restrict interner, size_t id) {
+    ARENA_ASSERT(id < interner->strings.length, "Invalid string id!");
+    return ARENA_VEC_AT(&interner->strings, const char*, id);
+}
+
+const char* arena_internn(arena_interner_t* restrict interner, 
+                          const char* restrict str, 
+                          size_t length) {
+    return arena_interned_string(interner, arena_intern_id(interner, str, length));
+}
+
+inline const char* arena_intern(arena_interner_t* restrict interner, const char* restrict str) {
+    return arena_internn(interner, str, strlen(str));
+}
+
+arena_pool_t create_arena_pool(arena_t* arena) {
+    arena_pool_t pool;
+
+    pool.arena = arena;
+
+    for(size_t i = 0; i < ARENA_POOL_CLASSES_COUNT; i++) {
+        pool.free_lists[i] = NULL;
+        pool.slabs[i] = NULL;
+        pool.slab_ends[i] = NULL;
+    }
+
+    return pool;
+}
+
+static inline size_t arena_pool_class(size_t size) {
+    return (size <= ARENA_POOL_MIN_SIZE) 
+        ? 0 
+        : floor_log2(size - 1) + 1 - floor_log2(ARENA_POOL_MIN_SIZE);
+}
+
+/*
+  A freed block is reused first, then the current slab of the class 
+  is bumped. The blocks larger than ARENA_POOL_MAX_SIZE are allocated 
+  from the arena directly.
+*/
+void* arena_pool_alloc(arena_pool_t* restrict pool, size_t size) {
+
+    if(size <= 0) {
+        return NULL;
+    }
+
+    if(size > ARENA_POOL_MAX_SIZE) {
+        return arena_alloc(pool->arena, size);
+    }
+
+    const size_t index = arena_pool_class(size);
+    const size_t class_size = (size_t)ARENA_POOL_MIN_SIZE << index;
+
+    void* const block = pool->free_lists[index];
+
+    if(block != NULL) {
+        pool->free_lists[index] = *(void**)block;
+        ARENA_UNPOISON(block, class_size);
+
+        return block;
+    }
+
+    if(pool->slabs[index] == pool->slab_ends[index]) {
+        const size_t slab_size = (ARENA_POOL_SLAB_SIZE > class_size) 
+            ? ARENA_POOL_SLAB_SIZE / class_size * class_size 
+            : class_size;
+
+        pool->slabs[index] = (uint8_t*)arena_alloc_aligned(pool->arena, slab_size, ARENA_POOL_MIN_SIZE);
+        pool->slab_ends[index] = pool->slabs[index] + slab_size;
+    }
+
+    uint8_t* const slab_block = pool->slabs[index];
+    pool->slabs[index] += class_size;
+
+    return slab_block;
+}
+
+/*
+  The block is pushed on the free list of its class, `size` must be 
+  the size given to arena_pool_alloc. A large block goes back to the 
+  arena only if it's the most recent allocation.
+*/
+void arena_pool_free(arena_pool_t* restrict pool, void* ptr, size_t size) {
+
+    if(ptr == NULL || size <= 0) {
+        return;
+    }
+
+    if(size > ARENA_POOL_MAX_SIZE) {
+        arena_free_last(pool->arena, ptr, size);
+        return;
+    }
+
+    const size_t index = arena_pool_class(size);
+    const size_t class_size = (size_t)ARENA_POOL_MIN_SIZE << index;
+
+    *(void**)ptr = pool->free_lists[index];
+    pool->free_lists[index] = ptr;
+
+    // A use after free is reported by ASan, only the link stays readable.
+    ARENA_POISON((uint8_t*)ptr + sizeof(void*), class_size - sizeof(void*));
+}
+
+void arena_reset(arena_t* restrict arena) {
+
+    ARENA_ASSERT(ARENA_COUNTER(arena->children_count) == 0, "The arena has child arenas!");
+
+    arena_check_redzones(arena);
+    arena_clear_redzones(arena);
+    arena_clear_index(arena);
+
+    arena_chunk_t* previous = arena->begin;
+    size_t retained_size = previous->size;
+
+    arena_chunk_rewind(previous, 0);
+
+    // The pages of the caller's buffer (or of the parent) are never given back.
+    if(previous != arena->buffer && arena->parent == NULL) {
+        arena_chunk_purge(previous, arena->max_retained_size);
+    }
+
+    /*
+      The first chunk is always kept, the others are kept while 
+      the retained capacity is below the high-water mark.
+    */
+    while(previous->next != NULL) {
+        arena_chunk_t* const chunk = previous->next;
+
+        if(retained_size + chunk->size > arena->max_retained_size) {
+            ARENA_ATOMIC_STORE(previous->next, chunk->next);
+
+            arena_detach_chunk(arena, chunk);
+            arena_release_chunk(arena, chunk);
+            continue;
+        }
+
+        retained_size += chunk->size;
+        arena_chunk_rewind(chunk, 0);
+
+        previous = chunk;
+    }
+
+    arena->end = arena->begin;
+    arena_index_chunk(arena, arena->begin);
+    arena_directory_rebuild(arena);
+
+    arena->stats.used = 0;
+}
+
+arena_mark_t arena_save(const arena_t* restrict arena) {
+    arena_mark_t mark;
+
+    mark.chunk = arena->end;
+    mark.last = arena->end;
+    mark.used = arena->end->used;
+
+    // The dedicated chunks in use behind the end belong to the mark too.
+    while(mark.last->next != NULL && mark.last->next->used != 0) {
+        mark.last = mark.last->next;
+    }
+
+#ifdef ARENA_CHECKED
+    mark.redzones_count = arena->redzones->count;
+#else
+    mark.redzones_count = 0;
+#endif
+
+    return mark;
+}
+
+void arena_restore(arena_t* restrict arena, arena_mark_t mark) {
+
+    ARENA_ASSERT(mark.used <= mark.chunk->used, "Invalid arena mark!");
+
+    arena_check_mark_redzones(arena, mark);
+
+    /*
+      The chunks filled after the mark (up to the end and the dedicated 
+      chunks in use behind it) are rewound and stay in the list, 
+      they'll be reused by the next allocations.
+    */
+    size_t released = mark.chunk->used - mark.used;
+    int past_end = mark.chunk == arena->end;
+
+    for(arena_chunk_t* it = mark.last->next; it != NULL && !(past_end && it->used == 0); it = it->next) {
+        past_end = past_end || it == arena->end;
+
+        released += it->used;
+        arena_chunk_rewind(it, 0);
+        arena_unindex_chunk(arena, it);
+    }
+
+    arena_count_release(arena, released);
+
+    arena_chunk_rewind(mark.chunk, mark.used);
+    arena->end = mark.chunk;
+    arena_index_chunk(arena, mark.chunk);
+    arena_prune_redzones(arena, mark);
+}
+
+void destroy_arena(arena_t* restrict arena) {
+
+    ARENA_ASSERT(ARENA_COUNTER(arena->children_count) == 0, "The arena has child arenas!");
+
+    arena_check_redzones(arena);
+
+#ifdef ARENA_PREFAULT_THREAD
+    arena_stop_prefault_thread(arena);
+#endif
+
+#ifdef ARENA_PREFAULT
+    if(arena->spare != NULL) {
+        arena_release_chunk(arena, arena->spare);
+    }
+#endif
+
+    arena_chunk_t* chunk;
+    arena_chunk_t* it = arena->begin;
+
+    while(it != NULL){
+        chunk = it;
+        it = it->next;
+
+        arena_detach_chunk(arena, chunk);
+        arena_release_chunk(arena, chunk);
+    }
+
+    delete_arena_directory(arena->directory);
+
+#ifdef ARENA_REDUCE_FRAGMENTATION
+    ARENA_FREE(arena->free_index);
+#endif
+
+#ifdef ARENA_CHECKED
+    delete_arena_redzones(arena->redzones);
+#endif
+
+    if(arena->parent != NULL) {
+        arena_t* const parent = arena->parent;
+
+        const size_t used = arena_used_space(parent);
+
+        // Only the chunks of the child have been allocated since the mark.
+        if(used == arena->parent_used) {
+            arena_restore(parent, arena->parent_mark);
+
+            if(ARENA_LOAD(parent->children_used) == used) {
+                ARENA_STORE(parent->children_used, arena_used_space(parent));
+            }
+        }
+
+        // Only the chunks of the children have been allocated since the first one.
+        if(ARENA_SUB(parent->children_count, 1) == 0 && 
+           arena_used_space(parent) == ARENA_LOAD(parent->children_used)) {
+            arena_restore(parent, parent->children_mark);
+        }
+    }
+}
+
+#ifdef ARENA_CHECKED
+
+/*
+  Checks the canary bytes of every redzone, returns 0 if an 
+  allocation has overflowed into its redzone. The redzones 
+  table is read under its lock.
+*/
+int arena_validate(const arena_t* restrict arena) {
+
+    ARENA_LOCK(arena->redzones->lock);
+    const int valid = arena_check_redzones_from(arena->redzones, 0);
+    ARENA_UNLOCK(arena->redzones->lock);
+
+    return valid;
+}
+
+#endif
+
+#ifdef ARENA_SNAPSHOT
+
+/*
+  A snapshot is the image of the chunks of an arena: the first page 
+  holds the header, then the used space of every chunk is written at 
+  its image offset (see arena_place_chunk). The image is mapped back 
+  read-only, the relative pointers are offsets from the mapping base.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// pwrite(), mkstemp() and fchmod() are hidden by a strict -std=c99 without a feature macro.
+#if defined(__STRICT_ANSI__) && \
+    !(defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L) && \
+    !(defined(_XOPEN_SOURCE) && _XOPEN_SOURCE >= 500)
+#error "ARENA_SNAPSHOT requires _DEFAULT_SOURCE (or _GNU_SOURCE) before any system header!"
+#endif
+
+#define ARENA_SNAPSHOT_MAGIC "ARENASNP"
+#define ARENA_SNAPSHOT_TEMPLATE ".XXXXXX"
+#define ARENA_SNAPSHOT_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint64_t version;
+    uint64_t size;
+    uint64_t root;
+} arena_snapshot_header_t;
+
+arena_rel_ptr_t arena_to_rel_ptr(const arena_t* restrict arena, const void* ptr) {
+
+    arena_rel_ptr_t rel_ptr;
+    rel_ptr.offset = 0;
+
+    if(ptr == NULL) {
+        return rel_ptr;
+    }
+
+    const uintptr_t address = (uintptr_t)ptr;
+
+    for(const arena_chunk_t* it = arena->begin; it != NULL; it = ARENA_LOAD(it->next)) {
+        const uintptr_t data = (uintptr_t)it->data;
+
+        if(address >= data && address - data < ARENA_LOAD(it->size)) {
+            rel_ptr.offset = it->image_offset + (uint64_t)(address - data);
+            return rel_ptr;
+        }
+    }
+
+    ARENA_ASSERT(0, "Pointer outside of the arena!");
+
+    return rel_ptr;
+}
+
+void* arena_from_rel_ptr(const arena_t* restrict arena, arena_rel_ptr_t rel_ptr) {
+
+    if(rel_ptr.offset == 0) {
+        return NULL;
+    }
+
+    for(arena_chunk_t* it = arena->begin; it != NULL; it = ARENA_LOAD(it->next)) {
+        if(rel_ptr.offset >= it->image_offset && 
+           rel_ptr.offset - it->image_offset < ARENA_LOAD(it->size)) {
+            return it->data + (rel_ptr.offset - it->image_offset);
+        }
+    }
+
+    ARENA_ASSERT(0, "Invalid relative pointer!");
+
+    return NULL;
+}
+
+static int arena_write_at(int fd, const void* data, size_t size, size_t offset) {
+
+    const uint8_t* bytes = (const uint8_t*)data;
+
+    while(size > 0) {
+        const ssize_t written = pwrite(fd, bytes, size, (off_t)offset);
+
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+
+            return 0;
+        }
+
+        bytes += written;
+        size -= (size_t)written;
+        offset += (size_t)written;
+    }
+
+    return 1;
+}
+
+/*
+  Writes the image of the arena to `path`, `root` (NULL or a 
+  pointer into the arena) is stored in the header. 
+  The unused ranges of the image are left as holes in the file. 
+  Returns 0 if the file can't be written.
+*/
+int arena_write_snapshot(const arena_t* restrict arena, 
+                         const void* root, 
+                         const char* restrict path) {
+
+    arena_snapshot_header_t header;
+    memset(&header, 0, sizeof(arena_snapshot_header_t));
+
+    memcpy(header.magic, ARENA_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = ARENA_SNAPSHOT_VERSION;
+    header.size = PAGE_SIZE;
+    header.root = arena_to_rel_ptr(arena, root).offset;
+
+    /*
+      The image is written to a temporary file, then renamed over `path`: 
+      a process mapping the previous snapshot keeps its own copy, it never 
+      sees the file shrink or change under its mapping.
+    */
+    const size_t path_length = strlen(path);
+    char* const temporary_path = ARENA_MALLOC(path_length + sizeof(ARENA_SNAPSHOT_TEMPLATE));
+    ARENA_ASSERT(temporary_path != NULL, "Unable to allocate memory!");
+
+    memcpy(temporary_path, path, path_length);
+    memcpy(temporary_path + path_length, ARENA_SNAPSHOT_TEMPLATE, sizeof(ARENA_SNAPSHOT_TEMPLATE));
+
+    const int fd = mkstemp(temporary_path);
+
+    if(fd < 0) {
+        ARENA_FREE(temporary_path);
+        return 0;
+    }
+
+    int result = fchmod(fd, 0644) == 0;
+
+    for(const arena_chunk_t* it = arena->begin; it != NULL && result; it = it->next) {
+        if(it->used == 0) {
+            continue;
+        }
+
+        result = arena_write_at(fd, it->data, it->used, it->image_offset);
+
+        if(it->image_offset + it->used > header.size) {
+            header.size = it->image_offset + it->used;
+        }
+    }
+
+    result = result && 
+        arena_write_at(fd, &header, sizeof(arena_snapshot_header_t), 0) &&
+        ftruncate(fd, (off_t)header.size) == 0 &&
+        fsync(fd) == 0;
+
+    result = (close(fd) == 0) && result && rename(temporary_path, path) == 0;
+
+    if(!result) {
+        unlink(temporary_path);
+    }
+
+    ARENA_FREE(temporary_path);
+
+    return result;
+}
+
+/*
+  Maps the snapshot at `path` read-only. The returned snapshot 
+  has a NULL `data` if the file can't be mapped or isn't a snapshot.
+*/
+arena_snapshot_t arena_map_snapshot(const char* restrict path) {
+
+    arena_snapshot_t snapshot;
+
+    snapshot.data = NULL;
+    snapshot.size = 0;
+    snapshot.root.offset = 0;
+
+    const int fd = open(path, O_RDONLY);
+
+    if(fd < 0) {
+        return snapshot;
+    }
+
+    struct stat status;
+
+    if(fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(arena_snapshot_header_t)) {
+        close(fd);
+        return snapshot;
+    }
+
+    const size_t size = (size_t)status.st_size;
+    void* const memory = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if(memory == MAP_FAILED) {
+        return snapshot;
+    }
+
+    const arena_snapshot_header_t* const header = (const arena_snapshot_header_t*)memory;
+
+    if(memcmp(header->magic, ARENA_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || 
+       header->version != ARENA_SNAPSHOT_VERSION || 
+       header->size > size || 
+       header->root >= header->size) {
+
+        munmap(memory, size);
+        return snapshot;
+    }
+
+    snapshot.data = (const uint8_t*)memory;
+    snapshot.size = size;
+    snapshot.root.offset = header->root;
+
+    return snapshot;
+}
+
+void arena_unmap_snapshot(arena_snapshot_t* restrict snapshot) {
+
+    if(snapshot->data != NULL) {
+        munmap((void*)snapshot->data, snapshot->size);
+    }
+
+    snapshot->data = NULL;
+    snapshot->size = 0;
+}
+
+const void* arena_snapshot_ptr(const arena_snapshot_t* restrict snapshot, arena_rel_ptr_t rel_ptr) {
+
+    if(rel_ptr.offset == 0) {
+        return NULL;
+    }
+
+    ARENA_ASSERT(rel_ptr.offset < snapshot->size, "Invalid relative pointer!");
+
+    return snapshot->data + rel_ptr.offset;
+}
+
+inline const void* arena_snapshot_root(const arena_snapshot_t* restrict snapshot) {
+    return arena_snapshot_ptr(snapshot, snapshot->root);
+}
+
+#endif
+
+#ifdef ARENA_DEBUG_MODE
+
+inline int arena_get_chunks_count(const arena_t* restrict arena) {
+    return (int)ARENA_COUNTER(arena->stats.chunks_count);
+}
+
+size_t arena_get_available_space_of(const arena_t* restrict arena, int chunk_index) {
+
+    const arena_chunk_t* const chunk = (chunk_index >= 0) 
+        ? arena_get_chunk(arena, (size_t)chunk_index) 
+        : NULL;
+
+    if(chunk == NULL) {
+        return 0;
+    }
+
+    return (chunk->size - ARENA_LOAD(chunk->used));
+}
+
+inline size_t arena_get_current_available_space(const arena_t* restrict arena) {
+    return (arena->end->size - arena->end->used);
+}
+
+size_t arena_get_used_space_of(const arena_t* restrict arena, int chunk_index) {
+
+    const arena_chunk_t* const chunk = (chunk_index >= 0) 
+        ? arena_get_chunk(arena, (size_t)chunk_index) 
+        : NULL;
+
+    if(chunk == NULL) {
+        return 0;
     }
 
-    return it->used;
+    return ARENA_LOAD(chunk->used);
 }
 
 inline size_t arena_get_current_used_space(const arena_t* restrict arena) {
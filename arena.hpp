@@ -0,0 +1,159 @@
+#ifndef _ARENA_HPP_
+#define _ARENA_HPP_
+
+/*
+  C++17 adapters for arena.h.
+
+  The implementation is still compiled as C: define ARENA_IMPLEMENTATION
+  in a single C source file (together with the same ARENA_* modes) and
+  only include this header from C++.
+*/
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+#ifdef ARENA_IMPLEMENTATION
+#error "arena.h must be implemented in a C translation unit."
+#endif
+
+// C++ has no restrict, a user's restrict macro is kept around the include.
+#pragma push_macro("restrict")
+#undef restrict
+#define restrict __restrict
+#include "arena.h"
+#pragma pop_macro("restrict")
+
+/*
+  Owns an arena and destroys it with the scope.
+*/
+class arena_owner {
+public:
+    explicit arena_owner(size_t chunk_size)
+        : arena(create_arena(chunk_size)) {}
+
+    arena_owner(size_t chunk_size, size_t alignment)
+        : arena(create_aligned_arena(chunk_size, alignment)) {}
+
+#ifdef ARENA_CHUNK_POOL
+    explicit arena_owner(arena_chunk_pool_t* pool)
+        : arena(arena_chunk_pool_create_arena(pool)) {}
+#endif
+
+    ~arena_owner() {
+        destroy_arena(&arena);
+    }
+
+    // The chunks link back to the arena, so it can't be copied or moved.
+    arena_owner(const arena_owner&) = delete;
+    arena_owner& operator=(const arena_owner&) = delete;
+
+    arena_t* get() noexcept { return &arena; }
+    const arena_t* get() const noexcept { return &arena; }
+
+    void reset() noexcept {
+        arena_reset(&arena);
+    }
+
+private:
+    arena_t arena;
+};
+
+/*
+  A std::pmr::memory_resource backed by an arena.
+  Deallocating only gives the memory back when the block is the most
+  recent allocation, everything else is released with the arena.
+  arena_free_last must not race with other allocations, so with
+  ARENA_THREAD_SAFE deallocating is a no-op.
+*/
+class arena_memory_resource : public std::pmr::memory_resource {
+public:
+    explicit arena_memory_resource(arena_t* arena) noexcept
+        : arena(arena) {}
+
+    arena_t* get_arena() const noexcept { return arena; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+
+        void* const ptr = arena_alloc_aligned(arena, bytes == 0 ? 1 : bytes, alignment);
+
+        if(ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        return ptr;
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        (void) alignment;
+#ifdef ARENA_THREAD_SAFE
+        (void) ptr;
+        (void) bytes;
+#else
+        arena_free_last(arena, ptr, bytes == 0 ? 1 : bytes);
+#endif
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+private:
+    arena_t* arena;
+};
+
+/*
+  A stateful STL allocator backed by an arena, with the same
+  deallocation rules as arena_memory_resource.
+*/
+template<class T>
+class arena_allocator {
+public:
+    using value_type = T;
+
+    explicit arena_allocator(arena_t* arena) noexcept
+        : arena(arena) {}
+
+    template<class U>
+    arena_allocator(const arena_allocator<U>& other) noexcept
+        : arena(other.get_arena()) {}
+
+    T* allocate(size_t count) {
+
+        T* const ptr = static_cast<T*>(arena_alloc_array(arena, count == 0 ? 1 : count, 
+                                                         sizeof(T), alignof(T)));
+
+        if(ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        return ptr;
+    }
+
+    void deallocate(T* ptr, size_t count) noexcept {
+#ifdef ARENA_THREAD_SAFE
+        (void) ptr;
+        (void) count;
+#else
+        arena_free_last(arena, ptr, (count == 0 ? 1 : count) * sizeof(T));
+#endif
+    }
+
+    arena_t* get_arena() const noexcept { return arena; }
+
+private:
+    arena_t* arena;
+};
+
+template<class T, class U>
+bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept {
+    return a.get_arena() == b.get_arena();
+}
+
+template<class T, class U>
+bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) noexcept {
+    return a.get_arena() != b.get_arena();
+}
+
+#endif
@@ -0,0 +1,350 @@
+#define _DEFAULT_SOURCE
+
+#include "bench.h"
+
+#include <string.h>
+
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#include "../arena.h"
+
+#if defined(ARENA_REDUCE_FRAGMENTATION) && defined(ARENA_BEST_FIT)
+#define ARENA_NAME "arena (best fit)"
+#elif defined(ARENA_REDUCE_FRAGMENTATION)
+#define ARENA_NAME "arena (first fit)"
+#else
+#define ARENA_NAME "arena"
+#endif
+
+#define SMALL_ALLOCATIONS_COUNT 1000000
+#define MIXED_ALLOCATIONS_COUNT 500000
+#define STRINGS_COUNT 1000000
+#define REALLOC_BUFFERS_COUNT 2000
+#define REALLOC_MAX_SIZE (64 * 1024)
+#define CHURN_LIVE_COUNT 10000
+#define CHURN_OPERATIONS_COUNT 2000000
+
+static size_t chunk_size = 64 * 1024;
+static size_t max_chunk_size = 1024 * 1024;
+
+static void* pointers[SMALL_ALLOCATIONS_COUNT];
+static size_t sizes[CHURN_LIVE_COUNT];
+static volatile uintptr_t sink;
+
+static const char* words[] = {
+    "GET", "/index.html", "HTTP/1.1", "Host", "localhost:8080", "User-Agent",
+    "Mozilla/5.0 (X11; Linux x86_64)", "Accept", "text/html,application/xhtml+xml",
+    "Accept-Language", "en-US,en;q=0.5", "Connection", "keep-alive",
+};
+
+#define WORDS_COUNT (sizeof(words) / sizeof(words[0]))
+
+static uint32_t random_state = 2463534242u;
+
+static uint32_t next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+
+    return random_state;
+}
+
+static arena_t create_bench_arena(void) {
+    arena_t arena = create_arena(chunk_size);
+    arena_set_max_chunk_size(&arena, max_chunk_size);
+
+    return arena;
+}
+
+static void finish_arena(arena_t* arena, bench_context_t* context) {
+    context->chunks_count = arena_get_chunks_count(arena);
+    destroy_arena(arena);
+}
+
+static void fill(void* ptr, size_t size) {
+    ((uint8_t*)ptr)[0] = 1;
+    ((uint8_t*)ptr)[size - 1] = 1;
+}
+
+// Small fixed size allocations
+
+static void small_allocations_malloc(bench_context_t* context) {
+    for(int i = 0; i < SMALL_ALLOCATIONS_COUNT; i++) {
+        pointers[i] = malloc(32);
+        fill(pointers[i], 32);
+    }
+
+    for(int i = 0; i < SMALL_ALLOCATIONS_COUNT; i++) {
+        free(pointers[i]);
+    }
+
+    context->operations_count = SMALL_ALLOCATIONS_COUNT;
+}
+
+static void small_allocations_arena(bench_context_t* context) {
+    arena_t arena = create_bench_arena();
+
+    for(int i = 0; i < SMALL_ALLOCATIONS_COUNT; i++) {
+        pointers[i] = arena_alloc(&arena, 32);
+        fill(pointers[i], 32);
+    }
+
+    context->operations_count = SMALL_ALLOCATIONS_COUNT;
+    finish_arena(&arena, context);
+}
+
+// Mixed sizes allocations, from 8 bytes to 4KB
+
+static size_t next_mixed_size(void) {
+    return 8 << (next_random() % 10);
+}
+
+static void mixed_allocations_malloc(bench_context_t* context) {
+    for(int i = 0; i < MIXED_ALLOCATIONS_COUNT; i++) {
+        const size_t size = next_mixed_size();
+
+        pointers[i] = malloc(size);
+        fill(pointers[i], size);
+    }
+
+    for(int i = 0; i < MIXED_ALLOCATIONS_COUNT; i++) {
+        free(pointers[i]);
+    }
+
+    context->operations_count = MIXED_ALLOCATIONS_COUNT;
+}
+
+static void mixed_allocations_arena(bench_context_t* context) {
+    arena_t arena = create_bench_arena();
+
+    for(int i = 0; i < MIXED_ALLOCATIONS_COUNT; i++) {
+        const size_t size = next_mixed_size();
+
+        pointers[i] = arena_alloc(&arena, size);
+        fill(pointers[i], size);
+    }
+
+    context->operations_count = MIXED_ALLOCATIONS_COUNT;
+    finish_arena(&arena, context);
+}
+
+// String duplication
+
+static void strings_malloc(bench_context_t* context) {
+    for(int i = 0; i < STRINGS_COUNT; i++) {
+        const char* word = words[i % WORDS_COUNT];
+
+        if(i % 2 == 0) {
+            pointers[i] = strdup(word);
+        } else {
+            pointers[i] = strndup(word, 3);
+        }
+    }
+
+    for(int i = 0; i < STRINGS_COUNT; i++) {
+        free(pointers[i]);
+    }
+
+    context->operations_count = STRINGS_COUNT;
+}
+
+static void strings_arena(bench_context_t* context) {
+    arena_t arena = create_bench_arena();
+
+    for(int i = 0; i < STRINGS_COUNT; i++) {
+        const char* word = words[i % WORDS_COUNT];
+
+        if(i % 2 == 0) {
+            pointers[i] = arena_strdup(&arena, word);
+        } else {
+            pointers[i] = arena_strndup(&arena, word, 3);
+        }
+    }
+
+    context->operations_count = STRINGS_COUNT;
+    finish_arena(&arena, context);
+}
+
+// Realloc growth, doubling a buffer from 16 bytes to 64KB
+
+static void realloc_growth_malloc(bench_context_t* context) {
+    size_t operations_count = 0;
+
+    for(int i = 0; i < REALLOC_BUFFERS_COUNT; i++) {
+        uint8_t* buffer = (uint8_t*)malloc(16);
+
+        for(size_t size = 16; size < REALLOC_MAX_SIZE; size *= 2) {
+            buffer = (uint8_t*)realloc(buffer, size * 2);
+            fill(buffer, size * 2);
+            operations_count++;
+        }
+
+        sink += (uintptr_t)buffer;
+        free(buffer);
+    }
+
+    context->operations_count = operations_count;
+}
+
+static void realloc_growth_arena(bench_context_t* context) {
+    arena_t arena = create_bench_arena();
+    size_t operations_count = 0;
+
+    for(int i = 0; i < REALLOC_BUFFERS_COUNT; i++) {
+        uint8_t* buffer = (uint8_t*)arena_alloc(&arena, 16);
+
+        for(size_t size = 16; size < REALLOC_MAX_SIZE; size *= 2) {
+            buffer = (uint8_t*)arena_realloc(&arena, buffer, size, size * 2);
+            fill(buffer, size * 2);
+            operations_count++;
+        }
+
+        sink += (uintptr_t)buffer;
+    }
+
+    context->operations_count = operations_count;
+    finish_arena(&arena, context);
+}
+
+// Realloc growth of two interleaved buffers, they're never at the arena tail
+
+static void interleaved_realloc_growth_malloc(bench_context_t* context) {
+    size_t operations_count = 0;
+
+    for(int i = 0; i < REALLOC_BUFFERS_COUNT / 2; i++) {
+        uint8_t* first = (uint8_t*)malloc(16);
+        uint8_t* second = (uint8_t*)malloc(16);
+
+        for(size_t size = 16; size < REALLOC_MAX_SIZE; size *= 2) {
+            first = (uint8_t*)realloc(first, size * 2);
+            second = (uint8_t*)realloc(second, size * 2);
+            fill(first, size * 2);
+            fill(second, size * 2);
+            operations_count += 2;
+        }
+
+        sink += (uintptr_t)first + (uintptr_t)second;
+        free(first);
+        free(second);
+    }
+
+    context->operations_count = operations_count;
+}
+
+static void interleaved_realloc_growth_arena(bench_context_t* context) {
+    arena_t arena = create_bench_arena();
+    size_t operations_count = 0;
+
+    for(int i = 0; i < REALLOC_BUFFERS_COUNT / 2; i++) {
+        uint8_t* first = (uint8_t*)arena_alloc(&arena, 16);
+        uint8_t* second = (uint8_t*)arena_alloc(&arena, 16);
+
+        for(size_t size = 16; size < REALLOC_MAX_SIZE; size *= 2) {
+            first = (uint8_t*)arena_realloc(&arena, first, size, size * 2);
+            second = (uint8_t*)arena_realloc(&arena, second, size, size * 2);
+            fill(first, size * 2);
+            fill(second, size * 2);
+            operations_count += 2;
+        }
+
+        sink += (uintptr_t)first + (uintptr_t)second;
+    }
+
+    context->operations_count = operations_count;
+    finish_arena(&arena, context);
+}
+
+// Steady-state churn, a random live object is replaced by a new one (16 to 512 bytes)
+
+static size_t next_churn_size(void) {
+    return 16 << (next_random() % 6);
+}
+
+static void churn_malloc(bench_context_t* context) {
+    for(int i = 0; i < CHURN_LIVE_COUNT; i++) {
+        sizes[i] = next_churn_size();
+        pointers[i] = malloc(sizes[i]);
+    }
+
+    for(int i = 0; i < CHURN_OPERATIONS_COUNT; i++) {
+        const uint32_t slot = next_random() % CHURN_LIVE_COUNT;
+
+        free(pointers[slot]);
+
+        sizes[slot] = next_churn_size();
+        pointers[slot] = malloc(sizes[slot]);
+        fill(pointers[slot], sizes[slot]);
+    }
+
+    for(int i = 0; i < CHURN_LIVE_COUNT; i++) {
+        free(pointers[i]);
+    }
+
+    context->operations_count = CHURN_OPERATIONS_COUNT;
+}
+
+static void churn_arena(bench_context_t* context) {
+    arena_t arena = create_bench_arena();
+    arena_pool_t pool = create_arena_pool(&arena);
+
+    for(int i = 0; i < CHURN_LIVE_COUNT; i++) {
+        sizes[i] = next_churn_size();
+        pointers[i] = arena_pool_alloc(&pool, sizes[i]);
+    }
+
+    for(int i = 0; i < CHURN_OPERATIONS_COUNT; i++) {
+        const uint32_t slot = next_random() % CHURN_LIVE_COUNT;
+
+        arena_pool_free(&pool, pointers[slot], sizes[slot]);
+
+        sizes[slot] = next_churn_size();
+        pointers[slot] = arena_pool_alloc(&pool, sizes[slot]);
+        fill(pointers[slot], sizes[slot]);
+    }
+
+    context->operations_count = CHURN_OPERATIONS_COUNT;
+    finish_arena(&arena, context);
+}
+
+typedef struct {
+    const char* name;
+    bench_function_t malloc_function;
+    bench_function_t arena_function;
+} benchmark_t;
+
+static const benchmark_t benchmarks[] = {
+    { "small allocations", small_allocations_malloc, small_allocations_arena },
+    { "mixed sizes", mixed_allocations_malloc, mixed_allocations_arena },
+    { "strdup/strndup", strings_malloc, strings_arena },
+    { "realloc growth", realloc_growth_malloc, realloc_growth_arena },
+    { "interleaved realloc growth", interleaved_realloc_growth_malloc, interleaved_realloc_growth_arena },
+    { "churn (arena_pool)", churn_malloc, churn_arena },
+};
+
+int main(int argc, char** argv) {
+
+    // Usage: allocations [chunk size] [max chunk size]
+    if(argc > 1) {
+        chunk_size = (size_t)atol(argv[1]);
+        max_chunk_size = chunk_size;
+    }
+
+    if(argc > 2) {
+        max_chunk_size = (size_t)atol(argv[2]);
+    }
+
+    printf("Chunk size: %zu bytes, max chunk size: %zu bytes\n", chunk_size, max_chunk_size);
+
+    for(size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+
+        // The malloc baseline doesn't depend on the arena mode.
+#ifndef ARENA_REDUCE_FRAGMENTATION
+        run_benchmark(benchmarks[i].name, "malloc", benchmarks[i].malloc_function);
+#endif
+        run_benchmark(benchmarks[i].name, ARENA_NAME, benchmarks[i].arena_function);
+    }
+
+    putchar('\n');
+
+    return 0;
+}
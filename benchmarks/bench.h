@@ -0,0 +1,66 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+typedef struct {
+    size_t operations_count;
+    int chunks_count;
+} bench_context_t;
+
+typedef void (*bench_function_t)(bench_context_t* context);
+
+static inline double bench_now_in_ns(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+/*
+  Every benchmark runs in a child process, so that the peak RSS 
+  reported by getrusage() belongs to that benchmark only.
+  The benchmark must set the number of operations it performed and, 
+  for the arenas, the number of chunks before destroying the arena.
+*/
+static inline void run_benchmark(const char* name, const char* allocator, bench_function_t function) {
+
+    fflush(stdout);
+
+    const pid_t pid = fork();
+
+    if(pid == 0) {
+        bench_context_t context = (bench_context_t){
+            .operations_count = 0,
+            .chunks_count = -1,
+        };
+
+        const double start = bench_now_in_ns();
+        function(&context);
+        const double elapsed = bench_now_in_ns() - start;
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        char chunks[16] = "-";
+
+        if(context.chunks_count >= 0) {
+            snprintf(chunks, sizeof(chunks), "%d", context.chunks_count);
+        }
+
+        printf("%-28s %-30s %9.2f ns/op %9ld KB peak RSS %8s chunks\n",
+               name, allocator, elapsed / context.operations_count, usage.ru_maxrss, chunks);
+
+        exit(0);
+    }
+
+    waitpid(pid, NULL, 0);
+}
+
+#endif
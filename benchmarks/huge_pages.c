@@ -0,0 +1,123 @@
+#define _DEFAULT_SOURCE
+
+#include "bench.h"
+
+#include <string.h>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define ARENA_IMPLEMENTATION
+#include "../arena.h"
+
+#ifdef ARENA_HUGE_PAGES
+#define BACKEND_NAME "huge pages"
+#else
+#define BACKEND_NAME "malloc"
+#endif
+
+/*
+  Pointer chasing over a random permutation of cache line sized nodes: 
+  almost every access touches a different page, so the throughput is 
+  dominated by the TLB misses.
+*/
+
+typedef struct _node {
+    struct _node* next;
+    uint64_t payload[7];
+} node_t;
+
+static uint64_t random_state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+
+    return random_state;
+}
+
+// Returns -1 if the performance counters aren't available.
+static int open_dtlb_misses_counter(void) {
+    struct perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+
+    attributes.type = PERF_TYPE_HW_CACHE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_DTLB | 
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) | 
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    return (int)syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+}
+
+int main(int argc, char** argv) {
+
+    const size_t total_size = (size_t)(argc > 1 ? atoi(argv[1]) : 512) << 20;
+    const size_t nodes_count = total_size / sizeof(node_t);
+    const size_t steps_count = nodes_count * 4;
+
+    arena_t arena = create_arena(HUGE_PAGE_SIZE);
+
+    node_t** const nodes = (node_t**)malloc(sizeof(node_t*) * nodes_count);
+
+    for(size_t i = 0; i < nodes_count; i++) {
+        nodes[i] = (node_t*)arena_alloc(&arena, sizeof(node_t));
+        nodes[i]->payload[0] = i;
+    }
+
+    for(size_t i = nodes_count - 1; i > 0; i--) {
+        const size_t j = next_random() % (i + 1);
+        node_t* const node = nodes[i];
+
+        nodes[i] = nodes[j];
+        nodes[j] = node;
+    }
+
+    for(size_t i = 0; i < nodes_count; i++) {
+        nodes[i]->next = nodes[(i + 1) % nodes_count];
+    }
+
+    const int counter = open_dtlb_misses_counter();
+
+    if(counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    const double start = bench_now_in_ns();
+
+    const node_t* it = nodes[0];
+    uint64_t checksum = 0;
+
+    for(size_t i = 0; i < steps_count; i++) {
+        checksum += it->payload[0];
+        it = it->next;
+    }
+
+    const double elapsed = bench_now_in_ns() - start;
+
+    printf("huge_pages [%-10s] %4zu MB: %6.2f ns/access", 
+           BACKEND_NAME, total_size >> 20, elapsed / steps_count);
+
+    uint64_t misses = 0;
+
+    if(counter >= 0 && read(counter, &misses, sizeof(misses)) == sizeof(misses)) {
+        printf(", %.3f dTLB misses/access", (double)misses / steps_count);
+        close(counter);
+    } else {
+        printf(", dTLB misses n/a");
+    }
+
+    printf(" (checksum %llu)\n", (unsigned long long)checksum);
+
+    free(nodes);
+    destroy_arena(&arena);
+
+    return 0;
+}
@@ -19,6 +19,21 @@ TEST_SUITE(arena_alloc) {
         destroy_arena(&arena);
     }
 
+    TEST_CASE("Allocating close to SIZE_MAX bytes") {
+
+        arena_t arena = create_arena(1024);
+
+        TEST_ASSERT(arena_alloc_aligned(&arena, SIZE_MAX - 15, 1) == NULL, "Expected a NULL pointer.");
+        TEST_ASSERT(arena_alloc(&arena, SIZE_MAX) == NULL, "Expected a NULL pointer.");
+        TEST_ASSERT(arena_alloc_aligned(&arena, SIZE_MAX / 2 - 16, 4096) == NULL, "Expected a NULL pointer.");
+        TEST_ASSERT(arena_calloc(&arena, 1, SIZE_MAX - 15) == NULL, "Expected a NULL pointer.");
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 1, "Expected no chunk allocated.");
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 0, "Expected 0 bytes used.");
+
+        destroy_arena(&arena);
+    }
+
     TEST_CASE("Allocating variables") {
         
         arena_t arena = create_arena(1024);
@@ -29,7 +44,11 @@ TEST_SUITE(arena_alloc) {
         *integer = 10;
         *decimal = 124.1;
 
-        const size_t expected_used_space = sizeof(*integer) + sizeof(*decimal);
+        // The integer is padded up to the default alignment before the decimal.
+        const size_t integer_slot_size = 
+            (sizeof(*integer) + ARENA_DEFAULT_ALIGNMENT - 1) & ~(ARENA_DEFAULT_ALIGNMENT - 1);
+
+        const size_t expected_used_space = integer_slot_size + sizeof(*decimal);
         const size_t used_space = arena_get_current_used_space(&arena);
 
         TEST_ASSERT(used_space == expected_used_space, 
@@ -73,61 +92,877 @@ TEST_SUITE(arena_alloc) {
         TEST_ASSERT(arena_get_current_available_space(&arena) == 1024 - double_array_size,
                     "Expected same value.");
 
-        TEST_ASSERT(arena_get_available_space_of(&arena, 0) == 1024 - integer_array_size,
-                    "Expected same value.");
+        TEST_ASSERT(arena_get_available_space_of(&arena, 0) == 1024 - integer_array_size,
+                    "Expected same value.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Allocating strings") {
+
+        arena_t arena = create_arena(1024);
+
+        const int param_count = 10;
+        const int max_url_param_length = 13;
+
+        const char* base_url = "http://fake-api.org";
+        
+        const int full_url_max_length = strlen(base_url) + param_count * max_url_param_length + 1 + param_count;
+        char* const full_url = (char*)arena_alloc(&arena, full_url_max_length);
+
+        strcpy(full_url, base_url);
+        strcat(full_url, "?");
+
+        char* const param_buffer = (char*)arena_alloc(&arena, max_url_param_length + 1);
+
+        for(int i = 0; i < param_count; i++) {
+            const int length = sprintf(param_buffer, "param%d=value%d", i, i);
+            param_buffer[length] = '\0';
+
+            strcat(full_url, param_buffer);
+            
+            if(i != param_count - 1) {
+                strcat(full_url, "&");
+            }
+        }
+
+        const char* expected_url = "http://fake-api.org?param0=value0&"
+            "param1=value1&param2=value2&param3=value3&param4=value4&"
+            "param5=value5&param6=value6&param7=value7&param8=value8&"
+            "param9=value9";
+
+        const size_t expected_used_space = max_url_param_length + 1 + full_url_max_length;
+        const size_t used_space = arena_get_current_used_space(&arena);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 1, "Expected one chunks.");
+
+        TEST_ASSERT(used_space == expected_used_space, 
+                    "Expected %lu bytes used, but got %lu bytes.", 
+                    expected_used_space, used_space);
+
+        TEST_ASSERT(arena_get_current_available_space(&arena) == 1024 - used_space,
+                    "Expected same value");
+
+        TEST_ASSERT(strcmp(full_url, expected_url) == 0, 
+                    "Expected '%s' but got '%s'", expected_url, full_url);
+
+        TEST_ASSERT(strlen(full_url) == strlen(expected_url), "Expected same string lengths.");
+
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_alloc_aligned) {
+
+    TEST_CASE("Aligned allocation: padding accounted as used space") {
+
+        arena_t arena = create_arena(256);
+
+        arena_strdup(&arena, "abc");
+        void* ptr = arena_alloc_aligned(&arena, 8, 16);
+
+        TEST_ASSERT((uintptr_t)ptr % 16 == 0, "Expected a 16-byte aligned pointer.");
+        
+        const size_t expected_used_space = 16 + 8;
+        const size_t used_space = arena_get_current_used_space(&arena);
+
+        TEST_ASSERT(used_space == expected_used_space, 
+                    "Expected %lu bytes used, but got %lu bytes.", 
+                    expected_used_space, used_space);
+
+        TEST_ASSERT(arena_get_current_available_space(&arena) == 256 - used_space,
+                    "Expected same value.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Aligned allocation: per-arena default alignment") {
+
+        arena_t arena = create_aligned_arena(256, 32);
+
+        arena_strdup(&arena, "a");
+        double* decimal = (double*)arena_alloc(&arena, sizeof(double));
+        
+        arena_strdup(&arena, "b");
+        int* integer = (int*)arena_alloc(&arena, sizeof(int));
+
+        TEST_ASSERT((uintptr_t)decimal % 32 == 0, "Expected a 32-byte aligned pointer.");
+        TEST_ASSERT((uintptr_t)integer % 32 == 0, "Expected a 32-byte aligned pointer.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Aligned allocation: 16, 32 and 64 bytes across chunk boundaries") {
+
+        arena_t arena = create_arena(256);
+
+        const size_t alignments[] = { 16, 32, 64 };
+        int misaligned = 0;
+
+        for(int i = 0; i < 3; i++) {
+            for(int j = 0; j < 20; j++) {
+                arena_strdup(&arena, "x");
+
+                uint8_t* ptr = (uint8_t*)arena_alloc_aligned(&arena, alignments[i], alignments[i]);
+                memset(ptr, 0xAB, alignments[i]);
+
+                if((uintptr_t)ptr % alignments[i] != 0) {
+                    misaligned++;
+                }
+            }
+        }
+
+        TEST_ASSERT(misaligned == 0, "Found %d misaligned pointers.", misaligned);
+        TEST_ASSERT(arena_get_chunks_count(&arena) > 1, "Expected more than one chunk.");
+
+        destroy_arena(&arena);
+    }
+}
+
+typedef struct {
+    char tag;
+    double value;
+} node_t;
+
+TEST_SUITE(arena_alloc_array) {
+
+    TEST_CASE("Array allocation: typed arrays") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        arena_strdup(&arena, "x");
+
+        node_t* nodes = ARENA_NEW(&arena, node_t, 10);
+        memset(nodes, 0, sizeof(node_t) * 10);
+
+        TEST_ASSERT((uintptr_t)nodes % ARENA_ALIGNOF(node_t) == 0, "Expected an aligned array.");
+        // The array is aligned to the type, not to the arena default alignment.
+        const size_t expected_used = ARENA_ALIGNOF(node_t) + sizeof(node_t) * 10;
+
+        TEST_ASSERT(arena_get_current_used_space(&arena) == expected_used, 
+                    "Expected %zu bytes used.", expected_used);
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Array allocation: overflowing sizes") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        TEST_ASSERT(arena_alloc_array(&arena, SIZE_MAX / 2, 4, 1) == NULL, "Expected NULL.");
+        TEST_ASSERT(ARENA_NEW(&arena, node_t, SIZE_MAX / 8) == NULL, "Expected NULL.");
+        TEST_ASSERT(arena_alloc_array(&arena, 0, 4, 1) == NULL, "Expected NULL.");
+
+        // The product doesn't overflow, but no chunk can hold it.
+        TEST_ASSERT(arena_alloc_array(&arena, 1, SIZE_MAX - 15, 1) == NULL, "Expected NULL.");
+        TEST_ASSERT(arena_alloc_array(&arena, SIZE_MAX / 16, 16, 16) == NULL, "Expected NULL.");
+        TEST_ASSERT(ARENA_NEW(&arena, node_t, SIZE_MAX / sizeof(node_t)) == NULL, "Expected NULL.");
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 1, "Expected no chunk allocated.");
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 0, "Expected 0 bytes used.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Batch allocation: objects carved from a single block") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        void* objects[8];
+        uint8_t* block = (uint8_t*)arena_alloc_batch(&arena, objects, 8, 20, 8);
+
+        uint8_t* ptrs[8];
+        int misplaced = 0;
+
+        for(int i = 0; i < 8; i++) {
+            ptrs[i] = (uint8_t*)objects[i];
+            memset(ptrs[i], i, 20);
+
+            if(ptrs[i] != block + i * 24 || (uintptr_t)ptrs[i] % 8 != 0) {
+                misplaced++;
+            }
+        }
+
+        TEST_ASSERT(misplaced == 0, "Found %d misplaced objects.", misplaced);
+        TEST_ASSERT(ptrs[0][19] == 0 && ptrs[7][0] == 7, "Expected different content.");
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 8 * 24, "Expected %d bytes used.", 8 * 24);
+
+        node_t* nodes[4] = { NULL };
+        ARENA_NEW_BATCH(&arena, node_t, nodes, 4);
+
+        TEST_ASSERT(nodes[1] == nodes[0] + 1 && nodes[3] == nodes[0] + 3, "Expected contiguous objects.");
+
+        node_t* untouched[2] = { NULL, NULL };
+        ARENA_NEW_BATCH(&arena, node_t, untouched, SIZE_MAX / 2);
+
+        TEST_ASSERT(untouched[0] == NULL && untouched[1] == NULL, "Expected the pointers to be untouched.");
+
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_calloc) {
+
+    TEST_CASE("Calloc: reused memory is cleared") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        uint8_t* ptr = (uint8_t*)arena_alloc(&arena, PAGE_SIZE);
+        memset(ptr, 0xAB, PAGE_SIZE);
+
+        arena_reset(&arena);
+
+        uint8_t* zeroed = (uint8_t*)arena_calloc(&arena, PAGE_SIZE / 4, 4);
+        int dirty = 0;
+
+        for(int i = 0; i < PAGE_SIZE; i++) {
+            dirty += zeroed[i] != 0;
+        }
+
+        TEST_ASSERT(zeroed == ptr, "Expected same memory address.");
+        TEST_ASSERT(dirty == 0, "Found %d non zero bytes.", dirty);
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Calloc: the dirty watermark follows the rewinds") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena.begin->dirty = 0; // Pretend the chunk is known zero.
+
+        arena_alloc(&arena, 100);
+        arena_mark_t mark = arena_save(&arena);
+
+        arena_alloc(&arena, 200);
+        TEST_ASSERT(arena.begin->dirty == 0, "Expected a zero watermark.");
+
+        // 100 bytes, padded to 112, and 200 bytes.
+        arena_restore(&arena, mark);
+        TEST_ASSERT(arena.begin->dirty == 312, "Expected the watermark at 312 bytes.");
+
+        arena_reset(&arena);
+        TEST_ASSERT(arena.begin->dirty == 312, "Expected the watermark at 312 bytes.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Calloc: overflowing sizes") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        TEST_ASSERT(arena_calloc(&arena, SIZE_MAX / 2, 4) == NULL, "Expected NULL.");
+        TEST_ASSERT(arena_calloc(&arena, 0, 4) == NULL, "Expected NULL.");
+
+        destroy_arena(&arena);
+    }
+}
+
+static void count_chunk_acquired(void* user_data, const arena_chunk_t* chunk) {
+    (void) chunk;
+    ((int*)user_data)[0]++;
+}
+
+static void count_chunk_released(void* user_data, const arena_chunk_t* chunk) {
+    (void) chunk;
+    ((int*)user_data)[1]++;
+}
+
+TEST_SUITE(arena_stats) {
+
+    TEST_CASE("Stats: requested bytes, padding and wasted bytes") {
+
+        arena_t arena = create_arena(1024);
+
+        arena_alloc_aligned(&arena, 10, 1);
+        arena_alloc_aligned(&arena, 10, 16);
+        arena_alloc(&arena, 1000);
+
+        const arena_stats_t stats = arena_get_stats(&arena);
+
+        TEST_ASSERT(stats.requested == 1020, "Expected 1020 bytes requested, but got %zu.", stats.requested);
+        TEST_ASSERT(stats.padding == 6, "Expected 6 bytes of padding, but got %zu.", stats.padding);
+        TEST_ASSERT(stats.wasted == 1024 - 26, "Expected %d bytes wasted, but got %zu.", 1024 - 26, stats.wasted);
+        TEST_ASSERT(stats.used == 1026, "Expected 1026 bytes used, but got %zu.", stats.used);
+        TEST_ASSERT(stats.chunks_count == 2, "Expected 2 chunks.");
+        TEST_ASSERT(stats.capacity == 2048, "Expected 2048 bytes of capacity.");
+        TEST_ASSERT(stats.malloc_calls == 2, "Expected 2 malloc calls.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Stats: used space and peak across rewinds") {
+
+        arena_t arena = create_arena(1024);
+        arena_set_max_retained_size(&arena, 1024);
+
+        arena_alloc(&arena, 512);
+        arena_mark_t mark = arena_save(&arena);
+
+        char* str = arena_strndup(&arena, "abc", 3);
+        arena_alloc(&arena, 1024);
+
+        arena_restore(&arena, mark);
+        TEST_ASSERT(arena_get_stats(&arena).used == 512, "Expected 512 bytes used.");
+
+        str = (char*)arena_alloc(&arena, 100);
+        str = (char*)arena_realloc(&arena, str, 100, 300);
+        TEST_ASSERT(arena_get_stats(&arena).used == 812, "Expected 812 bytes used.");
+
+        arena_realloc(&arena, str, 300, 200);
+        TEST_ASSERT(arena_get_stats(&arena).used == 712, "Expected 712 bytes used.");
+
+        arena_reset(&arena);
+
+        const arena_stats_t stats = arena_get_stats(&arena);
+
+        TEST_ASSERT(stats.used == 0, "Expected 0 bytes used.");
+        TEST_ASSERT(stats.peak_used == 512 + 4 + 1024, "Expected a peak of %d bytes.", 512 + 4 + 1024);
+        TEST_ASSERT(stats.chunks_count == 1 && stats.capacity == 1024, "Expected only the first chunk.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Stats: chunk hooks") {
+
+        int calls[2] = { 0, 0 };
+
+        arena_hooks_t hooks;
+        hooks.chunk_acquired = count_chunk_acquired;
+        hooks.chunk_released = count_chunk_released;
+        hooks.user_data = calls;
+
+        arena_t arena = create_arena(1024);
+        arena_set_max_retained_size(&arena, 2048);
+        arena_set_hooks(&arena, &hooks);
+
+        for(int i = 0; i < 4; i++) {
+            arena_alloc(&arena, 1024);
+        }
+
+        // The first chunk is acquired when the hooks are installed.
+        TEST_ASSERT(calls[0] == 4 && calls[1] == 0, "Expected 4 chunks acquired.");
+
+        arena_reset(&arena);
+        TEST_ASSERT(calls[1] == 2, "Expected 2 chunks released.");
+
+        destroy_arena(&arena);
+        TEST_ASSERT(calls[1] == 4, "Expected 4 chunks released.");
+    }
+
+    TEST_CASE("Stats: replacing the chunk hooks") {
+
+        int old_calls[2] = { 0, 0 };
+        int new_calls[2] = { 0, 0 };
+
+        arena_hooks_t old_hooks;
+        old_hooks.chunk_acquired = count_chunk_acquired;
+        old_hooks.chunk_released = count_chunk_released;
+        old_hooks.user_data = old_calls;
+
+        arena_hooks_t new_hooks = old_hooks;
+        new_hooks.user_data = new_calls;
+
+        arena_t arena = create_arena(1024);
+        arena_set_hooks(&arena, &old_hooks);
+
+        arena_alloc(&arena, 1000);
+        arena_alloc(&arena, 1000);
+        arena_set_hooks(&arena, &new_hooks);
+
+        TEST_ASSERT(old_calls[0] == 2 && old_calls[1] == 2, "Expected the old hooks to release 2 chunks.");
+        TEST_ASSERT(new_calls[0] == 2 && new_calls[1] == 0, "Expected the new hooks to acquire 2 chunks.");
+
+        arena_alloc(&arena, 1000);
+        destroy_arena(&arena);
+
+        TEST_ASSERT(new_calls[0] == 3 && new_calls[1] == 3, "Expected 3 chunks acquired and released.");
+    }
+}
+
+TEST_SUITE(arena_chunk_directory) {
+
+    TEST_CASE("Chunk directory: lookup by index") {
+
+        arena_t arena = create_arena(1024);
+
+        for(int i = 0; i < 100; i++) {
+            arena_alloc(&arena, 1000);
+        }
+
+        // The lookups only read the arena.
+        const arena_t* const view = &arena;
+
+        const arena_chunk_t* it = arena.begin;
+        int mismatches = 0;
+
+        for(int i = 0; i < 100; i++, it = it->next) {
+            mismatches += arena_get_chunk(view, i) != it;
+        }
+
+        TEST_ASSERT(mismatches == 0, "Found %d mismatching chunks.", mismatches);
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 100, "Expected 100 chunks.");
+        TEST_ASSERT(arena_get_chunk(&arena, 100) == NULL, "Expected NULL.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 100) == 0, "Expected 0 bytes for an index past the end.");
+        TEST_ASSERT(arena_get_available_space_of(&arena, 100) == 0, "Expected 0 bytes for an index past the end.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Chunk directory: chunks inserted before the retained ones") {
+
+        arena_t arena = create_arena(1024);
+
+        arena_alloc(&arena, 1000);
+        arena_mark_t mark = arena_save(&arena);
+
+        arena_alloc(&arena, 1000);
+        arena_alloc(&arena, 1000);
+
+        arena_restore(&arena, mark);
+
+        // Too big for the retained chunks, inserted right after the first one.
+        arena_alloc(&arena, 4000);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 4, "Expected 4 chunks.");
+        TEST_ASSERT(arena_get_chunk(&arena, 1) == arena.begin->next, "Expected the new chunk at index 1.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 1) == 4000, "Expected 4000 bytes used.");
+        TEST_ASSERT(arena_get_chunk(&arena, 3) == arena.begin->next->next->next, "Expected the retained chunk at index 3.");
+
+        arena_set_max_retained_size(&arena, 2048);
+        arena_reset(&arena);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 2, "Expected 2 chunks.");
+        TEST_ASSERT(arena_get_chunk(&arena, 1) == arena.begin->next, "Expected the retained chunk at index 1.");
+        TEST_ASSERT(arena_get_chunk(&arena, 2) == NULL, "Expected NULL.");
+
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_chunk_growth) {
+
+    TEST_CASE("Chunk growth: oversized allocation") {
+
+        arena_t arena = create_arena(64);
+
+        const size_t big_size = 1000;
+        uint8_t* big = (uint8_t*)arena_alloc(&arena, big_size);
+        memset(big, 0xAB, big_size);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 2, "Expected 2 chunks.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 1) == big_size, 
+                    "Expected a dedicated chunk filled by the allocation.");
+        TEST_ASSERT(arena.end == arena.begin, "Expected the end to stay on the first chunk.");
+
+        // The small allocations keep using the free space of the first chunk.
+        uint8_t* first = (uint8_t*)arena_alloc(&arena, 16);
+        uint8_t* second = (uint8_t*)arena_alloc(&arena, 16);
+
+        TEST_ASSERT(first == arena.begin->data && second == arena.begin->data + 16, 
+                    "Expected the allocations to come from the first chunk.");
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 2, "Expected 2 chunks.");
+
+        // The regular chunk size is not affected by the oversized allocation.
+        arena_alloc(&arena, 64);
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 3, "Expected 3 chunks.");
+        TEST_ASSERT(arena_get_current_available_space(&arena) == 0, "Expected a full regular chunk.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Chunk growth: restore rewinds the dedicated chunks") {
+
+        arena_t arena = create_arena(64);
+
+        arena_alloc(&arena, 1000);
+        arena_alloc(&arena, 16);
+
+        const arena_mark_t mark = arena_save(&arena);
+
+        arena_alloc(&arena, 2000);
+        arena_alloc(&arena, 64);
+        arena_alloc(&arena, 3000);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 5, "Expected 5 chunks.");
+
+        arena_restore(&arena, mark);
+
+        TEST_ASSERT(arena.end == arena.begin, "Expected the end to be back on the first chunk.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 0) == 16, "Expected the first chunk to be kept.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 1) == 1000, "Expected the dedicated chunk to be kept.");
+        TEST_ASSERT(arena_get_stats(&arena).used == 1016, "Expected the used space before the mark.");
+
+        for(size_t i = 2; i < 5; i++) {
+            TEST_ASSERT(arena_get_used_space_of(&arena, i) == 0, "Expected chunk %zu to be rewound.", i);
+        }
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Chunk growth: fixed size without a cap") {
+
+        arena_t arena = create_arena(256);
+
+        arena_alloc(&arena, 200);
+        arena_alloc(&arena, 200);
+
+        TEST_ASSERT(arena_get_current_available_space(&arena) == 256 - 200, "Expected same value.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Chunk growth: geometric growth up to the cap") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_set_max_chunk_size(&arena, 64 * PAGE_SIZE);
+
+        const size_t total_size = 4 * 1024 * 1024;
+        const size_t allocation_size = 256;
+
+        for(size_t allocated = 0; allocated < total_size; allocated += allocation_size) {
+            arena_alloc(&arena, allocation_size);
+        }
+
+        const int chunks_count = arena_get_chunks_count(&arena);
+
+        // 4K, 8K, ..., 256K and then 256K chunks: 22 chunks instead of 1024.
+        TEST_ASSERT(chunks_count == 22, "Expected 22 chunks, but got %d.", chunks_count);
+
+        TEST_ASSERT(arena_get_used_space_of(&arena, 1) == 2 * PAGE_SIZE, 
+                    "Expected the second chunk to be twice the first.");
+        
+        TEST_ASSERT(arena_get_current_used_space(&arena) + 
+                    arena_get_current_available_space(&arena) == 64 * PAGE_SIZE,
+                    "Expected the current chunk to be capped.");
+
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_reset) {
+
+    TEST_CASE("Reset: chunks are retained and reused") {
+
+        arena_t arena = create_arena(256);
+
+        void* first = arena_alloc(&arena, 200);
+        void* second = arena_alloc(&arena, 200);
+        void* third = arena_alloc(&arena, 200);
+
+        arena_reset(&arena);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 3, "Expected 3 retained chunks.");
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 0, "Expected an empty chunk.");
+
+        TEST_ASSERT(arena_alloc(&arena, 200) == first, "Expected same memory address.");
+        TEST_ASSERT(arena_alloc(&arena, 200) == second, "Expected same memory address.");
+        TEST_ASSERT(arena_alloc(&arena, 200) == third, "Expected same memory address.");
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 3, "Expected no new chunks.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Reset: oversized allocation after a reset") {
+
+        arena_t arena = create_arena(256);
+
+        arena_alloc(&arena, 200);
+        arena_alloc(&arena, 200);
+
+        arena_reset(&arena);
+
+        arena_alloc(&arena, 200);
+        uint8_t* big = (uint8_t*)arena_alloc(&arena, 1000);
+        memset(big, 0, 1000);
+
+        // The dedicated chunk is inserted before the retained one.
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 3, "Expected 3 chunks.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 1) == 1000, "Expected the dedicated chunk.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 2) == 0, "Expected the retained chunk.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Reset: chunks beyond the high-water mark are freed") {
+
+        arena_t arena = create_arena(256);
+        arena_set_max_retained_size(&arena, 512);
+
+        for(int i = 0; i < 8; i++) {
+            arena_alloc(&arena, 200);
+        }
+
+        arena_alloc(&arena, 4096);
+
+        arena_reset(&arena);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 2, "Expected 2 retained chunks.");
+
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_init_with_buffer) {
+
+    TEST_CASE("Buffer: allocations are served by the buffer") {
+
+        uint8_t buffer[1024];
+
+        arena_t arena;
+        arena_init_with_buffer(&arena, buffer, sizeof(buffer));
+
+        uint8_t* ptr = (uint8_t*)arena_alloc(&arena, 512);
+        memset(ptr, 0xAB, 512);
+
+        TEST_ASSERT(ptr > buffer && ptr + 512 <= buffer + sizeof(buffer), "Expected a pointer in the buffer.");
+        TEST_ASSERT(arena_get_stats(&arena).malloc_calls == 0, "Expected no chunk allocated with malloc.");
+        TEST_ASSERT(arena_get_stats(&arena).capacity == sizeof(buffer) - sizeof(arena_chunk_t), 
+                    "Expected the buffer without the chunk header.");
+
+        arena_reset(&arena);
+
+        TEST_ASSERT(arena_alloc(&arena, 512) == ptr, "Expected same memory address.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Buffer: the arena spills to the heap") {
+
+        uint8_t buffer[256];
+
+        arena_t arena;
+        arena_init_with_buffer(&arena, buffer + 1, sizeof(buffer) - 1);
+
+        void* first = arena_alloc(&arena, 64);
+        uint8_t* spilled = (uint8_t*)arena_alloc(&arena, 1024);
+        memset(spilled, 0xAB, 1024);
+
+        TEST_ASSERT(((uintptr_t)first & (ARENA_DEFAULT_ALIGNMENT - 1)) == 0, "Expected an aligned pointer.");
+        TEST_ASSERT(spilled < buffer || spilled >= buffer + sizeof(buffer), "Expected a heap pointer.");
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 2, "Expected 2 chunks.");
+        TEST_ASSERT(arena_get_stats(&arena).malloc_calls == 1, "Expected a chunk allocated with malloc.");
+        TEST_ASSERT(arena_get_chunk(&arena, 1)->size >= PAGE_SIZE, "Expected a chunk of at least a page.");
+
+        // Only the heap chunk is freed.
+        arena_set_max_retained_size(&arena, 0);
+        arena_reset(&arena);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 1, "Expected only the buffer.");
+        TEST_ASSERT(arena_alloc(&arena, 64) == first, "Expected same memory address.");
+
+        arena_alloc(&arena, 1024);
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_child) {
+
+    TEST_CASE("Child: chunks are carved from the parent") {
+
+        arena_t parent = create_arena(4096);
+        arena_t child = create_child_arena(&parent, 256);
+
+        uint8_t* first = (uint8_t*)arena_alloc(&child, 200);
+        uint8_t* second = (uint8_t*)arena_alloc(&child, 200);
+        memset(first, 0xAB, 200);
+        memset(second, 0xCD, 200);
+
+        const arena_chunk_t* parent_chunk = arena_get_chunk(&parent, 0);
+
+        TEST_ASSERT(arena_get_chunks_count(&child) == 2, "Expected 2 chunks.");
+        TEST_ASSERT(arena_get_stats(&child).malloc_calls == 0, "Expected no chunk allocated with malloc.");
+        TEST_ASSERT(arena_get_chunks_count(&parent) == 1, "Expected a single parent chunk.");
+        TEST_ASSERT(first > parent_chunk->data && second + 200 <= parent_chunk->data + parent_chunk->used, 
+                    "Expected the allocations in the parent chunk.");
+        TEST_ASSERT(arena_get_current_used_space(&parent) == 2 * (sizeof(arena_chunk_t) + 256), 
+                    "Expected the child chunks in the parent.");
+
+        destroy_arena(&child);
+        destroy_arena(&parent);
+    }
+
+    TEST_CASE("Child: destroying the child rolls the parent back") {
+
+        arena_t parent = create_arena(4096);
+
+        uint8_t* ptr = (uint8_t*)arena_alloc(&parent, 100);
+        const size_t used = arena_get_current_used_space(&parent);
+
+        arena_t child = create_child_arena(&parent, 256);
+
+        for(int i = 0; i < 8; i++) {
+            arena_alloc(&child, 200);
+        }
+
+        destroy_arena(&child);
+
+        TEST_ASSERT(arena_get_current_used_space(&parent) == used, "Expected the parent to be rolled back.");
+        TEST_ASSERT(arena_get_stats(&parent).used == used, "Expected the parent stats to be rolled back.");
+        TEST_ASSERT(arena_alloc(&parent, 100) == ptr + 112, "Expected the next block of the parent.");
+
+        destroy_arena(&parent);
+    }
+
+    TEST_CASE("Child: a parent allocation keeps the child memory") {
+
+        arena_t parent = create_arena(4096);
+        arena_t child = create_child_arena(&parent, 256);
+
+        arena_alloc(&child, 200);
+
+        char* str = arena_strdup(&parent, "parent");
+        const size_t used = arena_get_current_used_space(&parent);
+
+        destroy_arena(&child);
+
+        TEST_ASSERT(arena_get_current_used_space(&parent) == used, "Expected the parent to be unchanged.");
+        TEST_ASSERT(strcmp(str, "parent") == 0, "Expected same content.");
+
+        destroy_arena(&parent);
+    }
+
+    TEST_CASE("Child: siblings destroyed in creation order roll the parent back") {
+
+        arena_t parent = create_arena(4 * PAGE_SIZE);
+        arena_alloc(&parent, 100);
+
+        const size_t used = arena_get_current_used_space(&parent);
+
+        for(int round = 0; round < 3; round++) {
+            arena_t children[3];
+
+            for(int i = 0; i < 3; i++) {
+                children[i] = create_child_arena(&parent, 256);
+                arena_alloc(&children[i], 200);
+                arena_alloc(&children[i], 200);
+            }
+
+            destroy_arena(&children[0]);
+            destroy_arena(&children[1]);
+
+            TEST_ASSERT(arena_get_current_used_space(&parent) > used, "Expected the youngest child to be kept.");
+
+            destroy_arena(&children[2]);
+
+            TEST_ASSERT(arena_get_current_used_space(&parent) == used,
+                        "Expected %zu bytes used, got %zu bytes.", used, arena_get_current_used_space(&parent));
+        }
+
+        // A parent allocation between the siblings keeps their chunks.
+        arena_t first = create_child_arena(&parent, 256);
+        arena_alloc(&parent, 16);
+        arena_t second = create_child_arena(&parent, 256);
+
+        const size_t kept = arena_get_current_used_space(&parent);
+
+        destroy_arena(&first);
+        destroy_arena(&second);
+
+        TEST_ASSERT(arena_get_current_used_space(&parent) < kept, "Expected the youngest child to be rolled back.");
+        TEST_ASSERT(arena_get_current_used_space(&parent) > used + 16, "Expected the older child to be kept.");
+
+        destroy_arena(&parent);
+    }
+
+    TEST_CASE("Child: the parent destroy releases the carved chunks") {
+
+        int calls[2] = { 0, 0 };
+
+        arena_hooks_t hooks;
+        hooks.chunk_acquired = count_chunk_acquired;
+        hooks.chunk_released = count_chunk_released;
+        hooks.user_data = calls;
+
+        arena_t parent = create_arena(1024);
+        arena_set_hooks(&parent, &hooks);
+
+        arena_t child = create_child_arena(&parent, 512);
+
+        arena_alloc(&child, 400);
+        arena_alloc(&child, 400);
+        arena_alloc(&parent, 16);
+
+        destroy_arena(&child);
+
+        TEST_ASSERT(arena_get_chunks_count(&parent) == 2, "Expected a new parent chunk for the child.");
+
+        destroy_arena(&parent);
+
+        TEST_ASSERT(calls[0] == 2 && calls[1] == 2, "Expected all the parent chunks to be released.");
+    }
+}
+
+TEST_SUITE(arena_save_and_restore) {
+
+    TEST_CASE("Restore: rewind inside the same chunk") {
+
+        arena_t arena = create_arena(1024);
+
+        arena_alloc(&arena, 100);
+        
+        const arena_mark_t mark = arena_save(&arena);
+        const size_t used_space = arena_get_current_used_space(&arena);
+
+        void* scratch = arena_alloc(&arena, 200);
+        arena_strdup(&arena, "scratch string");
+
+        arena_restore(&arena, mark);
+
+        TEST_ASSERT(arena_get_current_used_space(&arena) == used_space, 
+                    "Expected %lu bytes used, but got %lu bytes.",
+                    used_space, arena_get_current_used_space(&arena));
+        
+        TEST_ASSERT(arena_alloc(&arena, 200) == scratch, "Expected same memory address.");
 
         destroy_arena(&arena);
     }
 
-    TEST_CASE("Allocating strings") {
+    TEST_CASE("Restore: chunks allocated after the mark are kept") {
 
-        arena_t arena = create_arena(1024);
+        arena_t arena = create_arena(256);
 
-        const int param_count = 10;
-        const int max_url_param_length = 13;
+        arena_alloc(&arena, 100);
 
-        const char* base_url = "http://fake-api.org";
-        
-        const int full_url_max_length = strlen(base_url) + param_count * max_url_param_length + 1 + param_count;
-        char* const full_url = (char*)arena_alloc(&arena, full_url_max_length);
+        const arena_mark_t mark = arena_save(&arena);
 
-        strcpy(full_url, base_url);
-        strcat(full_url, "?");
+        for(int i = 0; i < 4; i++) {
+            arena_alloc(&arena, 200);
+        }
 
-        char* const param_buffer = (char*)arena_alloc(&arena, max_url_param_length);
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 5, "Expected 5 chunks.");
 
-        for(int i = 0; i < param_count; i++) {
-            const int length = sprintf(param_buffer, "param%d=value%d", i, i);
-            param_buffer[length] = '\0';
+        arena_restore(&arena, mark);
 
-            strcat(full_url, param_buffer);
-            
-            if(i != param_count - 1) {
-                strcat(full_url, "&");
-            }
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 100, "Expected the marked used space.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 1) == 0, "Expected an empty chunk.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 4) == 0, "Expected an empty chunk.");
+
+        for(int i = 0; i < 4; i++) {
+            arena_alloc(&arena, 200);
         }
 
-        const char* expected_url = "http://fake-api.org?param0=value0&"
-            "param1=value1&param2=value2&param3=value3&param4=value4&"
-            "param5=value5&param6=value6&param7=value7&param8=value8&"
-            "param9=value9";
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 5, "Expected no new chunks.");
 
-        const size_t expected_used_space = max_url_param_length + full_url_max_length;
-        const size_t used_space = arena_get_current_used_space(&arena);
+        destroy_arena(&arena);
+    }
 
-        TEST_ASSERT(arena_get_chunks_count(&arena) == 1, "Expected one chunks.");
+    TEST_CASE("Restore: nested marks") {
 
-        TEST_ASSERT(used_space == expected_used_space, 
-                    "Expected %lu bytes used, but got %lu bytes.", 
-                    expected_used_space, used_space);
+        arena_t arena = create_arena(256);
 
-        TEST_ASSERT(arena_get_current_available_space(&arena) == 1024 - used_space,
-                    "Expected same value");
+        const arena_mark_t outer = arena_save(&arena);
+        arena_alloc(&arena, 200);
 
-        TEST_ASSERT(strcmp(full_url, expected_url) == 0, 
-                    "Expected '%s' but got '%s'", expected_url, full_url);
+        const arena_mark_t inner = arena_save(&arena);
+        arena_alloc(&arena, 200);
+        arena_alloc(&arena, 200);
 
-        TEST_ASSERT(strlen(full_url) == strlen(expected_url), "Expected same string lengths.");
+        arena_restore(&arena, inner);
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 200, "Expected the inner used space.");
+
+        arena_restore(&arena, outer);
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 0, "Expected the outer used space.");
 
         destroy_arena(&arena);
     }
@@ -152,14 +987,15 @@ TEST_SUITE(arena_realloc) {
         const int new_array_size = sizeof(int) * new_array_length;
         int* integers2 = (int*)arena_realloc(&arena, integers, initial_array_size, new_array_size);
 
-        const size_t expected_used_space = initial_array_size + new_array_size;
+        // The array is the most recent allocation, so it grows in place.
+        const size_t expected_used_space = new_array_size;
         const size_t used_space = arena_get_current_used_space(&arena);
 
         TEST_ASSERT(used_space == expected_used_space, 
                     "Expected %lu bytes used, but got %lu bytes.", 
                     expected_used_space, used_space);
 
-        TEST_ASSERT(memcmp(integers, integers2, initial_array_length) == 0, "Expected same content.");
+        TEST_ASSERT(integers2 == integers, "Expected same memory address.");
         
         destroy_arena(&arena);
     }
@@ -181,14 +1017,15 @@ TEST_SUITE(arena_realloc) {
         const int new_array_size = sizeof(int) * new_array_length;
         int* integers2 = (int*)arena_realloc(&arena, integers, initial_array_size, new_array_size);
 
-        const size_t expected_used_space = initial_array_size + new_array_size;
+        // The array is the most recent allocation, so it shrinks in place.
+        const size_t expected_used_space = new_array_size;
         const size_t used_space = arena_get_current_used_space(&arena);
 
         TEST_ASSERT(used_space == expected_used_space, 
                     "Expected %lu bytes used, but got %lu bytes.", 
                     expected_used_space, used_space);
 
-        TEST_ASSERT(memcmp(integers2, integers, new_array_size) == 0, "Expected same content.");
+        TEST_ASSERT(integers2 == integers, "Expected same memory address.");
         
         destroy_arena(&arena);
     }
@@ -243,6 +1080,103 @@ TEST_SUITE(arena_realloc) {
     }
 }
 
+TEST_SUITE(arena_realloc_in_place) {
+
+    TEST_CASE("Realloc in place: doubling the most recent allocation") {
+
+        arena_t arena = create_arena(1024);
+
+        size_t size = 16;
+        uint8_t* buffer = (uint8_t*)arena_alloc(&arena, size);
+        uint8_t* const original_buffer = buffer;
+
+        memset(buffer, 0xAB, size);
+
+        while(size < 1024) {
+            buffer = (uint8_t*)arena_realloc(&arena, buffer, size, size * 2);
+            memset(buffer + size, 0xAB, size);
+            size *= 2;
+        }
+
+        TEST_ASSERT(buffer == original_buffer, "Expected no copies.");
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 1024, "Expected no dead memory.");
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 1, "Expected one chunk.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Realloc in place: shrinking never copies") {
+
+        arena_t arena = create_arena(1024);
+
+        uint8_t* buffer = (uint8_t*)arena_alloc(&arena, 256);
+        arena_alloc(&arena, 16);
+
+        const size_t used_space = arena_get_current_used_space(&arena);
+        uint8_t* buffer2 = (uint8_t*)arena_realloc(&arena, buffer, 256, 64);
+
+        TEST_ASSERT(buffer2 == buffer, "Expected same memory address.");
+        TEST_ASSERT(arena_get_current_used_space(&arena) == used_space, 
+                    "Expected the used space to be unchanged.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Realloc in place: growing a block that isn't the most recent allocation") {
+
+        arena_t arena = create_arena(1024);
+
+        int* integers = (int*)arena_alloc(&arena, 4 * sizeof(int));
+        arena_alloc(&arena, 16);
+
+        for(int i = 0; i < 4; i++) {
+            integers[i] = i;
+        }
+
+        int* integers2 = (int*)arena_realloc(&arena, integers, 4 * sizeof(int), 8 * sizeof(int));
+
+        TEST_ASSERT(integers2 != integers, "Expected a different memory address.");
+        TEST_ASSERT(memcmp(integers2, integers, 4 * sizeof(int)) == 0, "Expected same content.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Free last: only the most recent allocation is given back") {
+
+        arena_t arena = create_arena(1024);
+
+        uint8_t* first = (uint8_t*)arena_alloc(&arena, 64);
+        uint8_t* second = (uint8_t*)arena_alloc(&arena, 64);
+
+        arena_free_last(&arena, first, 64);
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 128, "Expected the used space to be unchanged.");
+
+        arena_free_last(&arena, second, 64);
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 64, "Expected 64 bytes used.");
+        TEST_ASSERT(arena_get_stats(&arena).used == 64, "Expected 64 bytes used in the stats.");
+
+        TEST_ASSERT(arena_alloc(&arena, 64) == second, "Expected same memory address.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Realloc in place: growing past the end of the chunk") {
+
+        arena_t arena = create_arena(256);
+
+        uint8_t* buffer = (uint8_t*)arena_alloc(&arena, 128);
+        memset(buffer, 0xAB, 128);
+
+        uint8_t* buffer2 = (uint8_t*)arena_realloc(&arena, buffer, 128, 512);
+
+        TEST_ASSERT(buffer2 != buffer, "Expected a different memory address.");
+        TEST_ASSERT(memcmp(buffer2, buffer, 128) == 0, "Expected same content.");
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 2, "Expected 2 chunks.");
+
+        destroy_arena(&arena);
+    }
+}
+
 TEST_SUITE(arena_strdup_and_strndup) {
 
     TEST_CASE("strdup: empty string") { 
@@ -316,14 +1250,348 @@ TEST_SUITE(arena_strdup_and_strndup) {
     }
 }
 
+TEST_SUITE(arena_vec) {
+
+    TEST_CASE("Vector: pushing elements") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_vec_t vec = create_arena_vec(&arena, sizeof(int));
+
+        for(int i = 0; i < 100; i++) {
+            arena_vec_push(&vec, &i);
+        }
+
+        int wrong = 0;
+
+        for(int i = 0; i < 100; i++) {
+            wrong += ARENA_VEC_AT(&vec, int, i) != i;
+        }
+
+        TEST_ASSERT(vec.length == 100, "Expected 100 elements.");
+        TEST_ASSERT(vec.capacity == 128, "Expected a capacity of 128 elements.");
+        TEST_ASSERT(wrong == 0, "Found %d wrong elements.", wrong);
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Vector: growing at the tail of the arena never moves") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_vec_t vec = create_arena_vec(&arena, sizeof(int));
+
+        const int values[4] = { 1, 2, 3, 4 };
+        arena_vec_push_n(&vec, values, 4);
+
+        void* const data = vec.data;
+
+        for(int i = 0; i < 250; i++) {
+            arena_vec_push_n(&vec, values, 4);
+        }
+
+        TEST_ASSERT(vec.data == data, "Expected same memory address.");
+
+        int* elements = (int*)arena_vec_finalize(&vec);
+
+        TEST_ASSERT(elements == data, "Expected same memory address.");
+        TEST_ASSERT(elements[1003] == 4, "Expected 4.");
+        TEST_ASSERT(arena_get_current_used_space(&arena) == sizeof(int) * 1004, 
+                    "Expected the unused capacity to be given back.");
+        TEST_ASSERT(vec.data == NULL && vec.length == 0, "Expected an empty vector.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Vector: interleaved vectors are relocated") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        arena_vec_t first = create_arena_vec(&arena, sizeof(size_t));
+        arena_vec_t second = create_arena_vec(&arena, sizeof(size_t));
+
+        for(size_t i = 0; i < 1000; i++) {
+            arena_vec_push(&first, &i);
+            arena_vec_push(&second, &i);
+        }
+
+        int wrong = 0;
+
+        for(size_t i = 0; i < 1000; i++) {
+            wrong += ARENA_VEC_AT(&first, size_t, i) != i;
+            wrong += ARENA_VEC_AT(&second, size_t, i) != i;
+        }
+
+        TEST_ASSERT(wrong == 0, "Found %d wrong elements.", wrong);
+
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_strbuf) {
+
+    TEST_CASE("String builder: building an URL") {
+
+        arena_t arena = create_arena(1024);
+        arena_strbuf_t strbuf = create_arena_strbuf(&arena);
+
+        arena_strbuf_append(&strbuf, "http://fake-api.org");
+        arena_strbuf_appendn(&strbuf, "?&", 1);
+
+        for(int i = 0; i < 10; i++) {
+            arena_strbuf_appendf(&strbuf, "%sparam%d=value%d", (i == 0) ? "" : "&", i, i);
+        }
+
+        const char* expected_url = "http://fake-api.org?param0=value0&"
+            "param1=value1&param2=value2&param3=value3&param4=value4&"
+            "param5=value5&param6=value6&param7=value7&param8=value8&"
+            "param9=value9";
+
+        char* url = arena_strbuf_finalize(&strbuf);
+
+        TEST_ASSERT(strcmp(url, expected_url) == 0, 
+                    "Expected '%s' but got '%s'", expected_url, url);
+        TEST_ASSERT(arena_get_current_used_space(&arena) == strlen(expected_url) + 1, 
+                    "Expected a tight string.");
+        TEST_ASSERT(strbuf.data == NULL && strbuf.length == 0, "Expected an empty string builder.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("String builder: long formatted strings") {
+
+        arena_t arena = create_arena(1024);
+        arena_strbuf_t strbuf = create_arena_strbuf(&arena);
+
+        char long_string[2000];
+        memset(long_string, 'a', sizeof(long_string) - 1);
+        long_string[sizeof(long_string) - 1] = '\0';
+
+        arena_strbuf_appendf(&strbuf, "%s-%d", long_string, 42);
+
+        TEST_ASSERT(strbuf.length == 2002, "Expected 2002 characters.");
+        TEST_ASSERT(strcmp(strbuf.data + 1999, "-42") == 0, "Expected '-42'.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("String builder: empty string") {
+
+        arena_t arena = create_arena(1024);
+        arena_strbuf_t strbuf = create_arena_strbuf(&arena);
+
+        char* str = arena_strbuf_finalize(&strbuf);
+
+        TEST_ASSERT(str != NULL && str[0] == '\0', "Expected an empty string.");
+
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_map) {
+
+    TEST_CASE("Map: put and get") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_map_t map = create_arena_map(&arena, 0);
+
+        char keys[1000][8];
+        int values[1000];
+
+        for(int i = 0; i < 1000; i++) {
+            const int length = sprintf(keys[i], "key%d", i);
+            values[i] = i;
+
+            arena_map_put(&map, keys[i], length, &values[i]);
+        }
+
+        int wrong = 0;
+
+        for(int i = 0; i < 1000; i++) {
+            const int* value = (const int*)arena_map_get(&map, keys[i], strlen(keys[i]));
+            wrong += value == NULL || *value != i;
+        }
+
+        TEST_ASSERT(wrong == 0, "Found %d wrong values.", wrong);
+        TEST_ASSERT(map.count == 1000, "Expected 1000 keys.");
+        TEST_ASSERT(map.count <= map.capacity / 4 * 3, "Expected a load factor below 3/4.");
+        TEST_ASSERT(arena_map_get(&map, "key1000", 7) == NULL, "Expected a missing key.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Map: overwriting a key") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_map_t map = create_arena_map(&arena, 100);
+
+        const size_t capacity = map.capacity;
+        int first = 1, second = 2;
+
+        arena_map_put(&map, "key", 3, &first);
+        arena_map_put(&map, "key", 3, &second);
+
+        TEST_ASSERT(map.count == 1, "Expected one key.");
+        TEST_ASSERT(arena_map_get(&map, "key", 3) == &second, "Expected the second value.");
+        TEST_ASSERT(arena_map_get(&map, "ke", 2) == NULL, "Expected a missing key.");
+        TEST_ASSERT(capacity == 256, "Expected 256 slots for 100 keys.");
+
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_interner) {
+
+    TEST_CASE("Interner: equal strings share the same pointer") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_interner_t interner = create_arena_interner(&arena);
+
+        char buffer[16];
+        strcpy(buffer, "symbol");
+
+        const char* first = arena_intern(&interner, "symbol");
+        const char* second = arena_intern(&interner, buffer);
+        const char* third = arena_internn(&interner, "symbols", 6);
+        const char* other = arena_intern(&interner, "other");
+
+        TEST_ASSERT(first == second && second == third, "Expected same memory address.");
+        TEST_ASSERT(first != other, "Expected different memory addresses.");
+        TEST_ASSERT(first != buffer && strcmp(first, "symbol") == 0, "Expected a copy.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Interner: ids") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_interner_t interner = create_arena_interner(&arena);
+
+        char buffer[16];
+        int wrong = 0;
+
+        for(int i = 0; i < 500; i++) {
+            const int length = sprintf(buffer, "name%d", i % 100);
+            const size_t id = arena_intern_id(&interner, buffer, length);
+
+            wrong += id != (size_t)(i % 100);
+        }
+
+        TEST_ASSERT(wrong == 0, "Found %d wrong ids.", wrong);
+        TEST_ASSERT(interner.strings.length == 100, "Expected 100 strings.");
+        TEST_ASSERT(strcmp(arena_interned_string(&interner, 42), "name42") == 0, "Expected 'name42'.");
+
+        destroy_arena(&arena);
+    }
+}
+
+TEST_SUITE(arena_pool) {
+
+    TEST_CASE("Pool: freed blocks are reused by their size class") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_pool_t pool = create_arena_pool(&arena);
+
+        void* first = arena_pool_alloc(&pool, 24);
+        void* second = arena_pool_alloc(&pool, 30);
+
+        TEST_ASSERT((uint8_t*)second == (uint8_t*)first + 32, "Expected adjacent blocks of 32 bytes.");
+
+        arena_pool_free(&pool, first, 24);
+
+        TEST_ASSERT(arena_pool_alloc(&pool, 100) != first, "Expected a block of another class.");
+        TEST_ASSERT(arena_pool_alloc(&pool, 20) == first, "Expected same memory address.");
+        TEST_ASSERT(arena_pool_alloc(&pool, 20) != first, "Expected a new block.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Pool: churn doesn't grow the arena") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_pool_t pool = create_arena_pool(&arena);
+
+        void* blocks[64];
+        size_t sizes[64];
+
+        for(int i = 0; i < 64; i++) {
+            sizes[i] = 8 + (size_t)i * 7;
+            blocks[i] = arena_pool_alloc(&pool, sizes[i]);
+        }
+
+        // Every block is freed and allocated again with another size of its class.
+        for(int i = 0; i < 64; i++) {
+            arena_pool_free(&pool, blocks[i], sizes[i]);
+            blocks[i] = arena_pool_alloc(&pool, sizes[i]);
+        }
+
+        const size_t used = arena_get_stats(&arena).used;
+
+        for(int round = 0; round < 100; round++) {
+            for(int i = 0; i < 64; i++) {
+                arena_pool_free(&pool, blocks[i], sizes[i]);
+            }
+
+            for(int i = 63; i >= 0; i--) {
+                blocks[i] = arena_pool_alloc(&pool, sizes[i]);
+                memset(blocks[i], i, sizes[i]);
+            }
+        }
+
+        int corrupted = 0;
+
+        for(int i = 0; i < 64; i++) {
+            if(((uint8_t*)blocks[i])[0] != i || ((uint8_t*)blocks[i])[sizes[i] - 1] != i) {
+                corrupted++;
+            }
+        }
+
+        TEST_ASSERT(corrupted == 0, "Found %d corrupted blocks.", corrupted);
+        TEST_ASSERT(arena_get_stats(&arena).used == used, "Expected the same used space.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Pool: large blocks are allocated from the arena") {
+
+        arena_t arena = create_arena(2 * PAGE_SIZE);
+        arena_pool_t pool = create_arena_pool(&arena);
+
+        void* large = arena_pool_alloc(&pool, ARENA_POOL_MAX_SIZE + 1);
+
+        TEST_ASSERT(arena_get_current_used_space(&arena) == ARENA_POOL_MAX_SIZE + 1, "Expected an arena allocation.");
+
+        arena_pool_free(&pool, large, ARENA_POOL_MAX_SIZE + 1);
+
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 0, "Expected the block to be given back.");
+        TEST_ASSERT(arena_pool_alloc(&pool, 0) == NULL, "Expected NULL.");
+
+        destroy_arena(&arena);
+    }
+}
+
 int main(int argc, char** argv, test_context_t* context) {
 
     (void) argc;
     (void) argv;
 
     RUN_SUITE(arena_alloc, context);
+    RUN_SUITE(arena_alloc_aligned, context);
+    RUN_SUITE(arena_alloc_array, context);
+    RUN_SUITE(arena_calloc, context);
+    RUN_SUITE(arena_stats, context);
+    RUN_SUITE(arena_chunk_directory, context);
+    RUN_SUITE(arena_chunk_growth, context);
+    RUN_SUITE(arena_reset, context);
+    RUN_SUITE(arena_init_with_buffer, context);
+    RUN_SUITE(arena_child, context);
+    RUN_SUITE(arena_save_and_restore, context);
     RUN_SUITE(arena_realloc, context);
+    RUN_SUITE(arena_realloc_in_place, context);
     RUN_SUITE(arena_strdup_and_strndup, context);
+    RUN_SUITE(arena_vec, context);
+    RUN_SUITE(arena_strbuf, context);
+    RUN_SUITE(arena_map, context);
+    RUN_SUITE(arena_interner, context);
+    RUN_SUITE(arena_pool, context);
 
     PRINT_WRAP_UP(context);
 
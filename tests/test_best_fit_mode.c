@@ -0,0 +1,71 @@
+#include "test.h"
+
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#define ARENA_REDUCE_FRAGMENTATION
+#define ARENA_BEST_FIT
+#include "../arena.h"
+
+TEST_SUITE(best_fit_mode) {
+
+    TEST_CASE("Best fit: the tightest hole is used") {
+
+        arena_t arena = create_arena(1024);
+        arena_set_max_chunk_size(&arena, 4096);
+
+        // 600 free bytes in the first chunk.
+        uint8_t* first = (uint8_t*)arena_alloc(&arena, 424);
+
+        // Fills the second chunk (2048 bytes).
+        arena_alloc(&arena, 1000);
+        arena_alloc(&arena, 1040);
+
+        // 900 free bytes in the third chunk (4096 bytes), same bin of the first one.
+        arena_alloc(&arena, 3196);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 3, "Expected 3 chunks.");
+
+        // First fit would take the head of the bin, the third chunk.
+        uint8_t* ptr = (uint8_t*)arena_alloc(&arena, 550);
+
+        TEST_ASSERT(ptr >= first && ptr < first + 1024, "Expected an allocation in the first chunk.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Best fit: the scan of a bin is capped") {
+
+        arena_t arena = create_arena(1024);
+
+        // 600 free bytes in the first chunk.
+        uint8_t* first = (uint8_t*)arena_alloc(&arena, 424);
+
+        // Chunks with 900 free bytes, same bin of the first one, pushed in front of it.
+        for(int i = 0; i < ARENA_BEST_FIT_MAX_SCAN; i++) {
+            void* ptr = arena_alloc(&arena, 1000);
+            arena_realloc(&arena, ptr, 1000, 124);
+        }
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == ARENA_BEST_FIT_MAX_SCAN + 1, "Expected %d chunks.", 
+                    ARENA_BEST_FIT_MAX_SCAN + 1);
+
+        // The first chunk is past the scanned ones.
+        uint8_t* ptr = (uint8_t*)arena_alloc(&arena, 550);
+
+        TEST_ASSERT(ptr < first || ptr >= first + 1024, "Expected an allocation in a scanned chunk.");
+
+        destroy_arena(&arena);
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(best_fit_mode, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "test.h"
+
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#define ARENA_CHECKED
+#include "../arena.h"
+
+#include <string.h>
+
+// The redzones are only readable outside of AddressSanitizer.
+static int is_filled(const uint8_t* ptr, size_t size, uint8_t byte) {
+
+#ifdef ARENA_ASAN
+    (void) byte;
+    return __asan_region_is_poisoned((void*)ptr, size) != NULL;
+#else
+    for(size_t i = 0; i < size; i++) {
+        if(ptr[i] != byte) {
+            return 0;
+        }
+    }
+
+    return 1;
+#endif
+}
+
+TEST_SUITE(checked_mode) {
+
+    TEST_CASE("Checked: allocations are separated by redzones") {
+
+        arena_t arena = create_arena(1024);
+
+        uint8_t* first = (uint8_t*)arena_alloc(&arena, 10);
+        uint8_t* second = (uint8_t*)arena_alloc(&arena, 10);
+
+        memset(first, 0xAB, 10);
+        memset(second, 0xAB, 10);
+
+        TEST_ASSERT(second >= first + 10 + ARENA_REDZONE_SIZE, "Expected a redzone between the allocations.");
+        TEST_ASSERT(is_filled(first + 10, ARENA_REDZONE_SIZE, ARENA_REDZONE_BYTE), "Expected a guarded redzone.");
+        TEST_ASSERT(arena_validate(&arena), "Expected intact redzones.");
+
+        const arena_stats_t stats = arena_get_stats(&arena);
+
+        TEST_ASSERT(stats.requested == 20, "Expected the redzones not to be requested.");
+        TEST_ASSERT(stats.used == arena_get_current_used_space(&arena), "Expected the redzones to be used.");
+
+        destroy_arena(&arena);
+    }
+
+#ifndef ARENA_ASAN
+    TEST_CASE("Checked: an overflow is detected") {
+
+        arena_t arena = create_arena(1024);
+
+        char* str = arena_strdup(&arena, "redzone");
+        arena_alloc(&arena, 10);
+
+        TEST_ASSERT(arena_validate(&arena), "Expected intact redzones.");
+
+        // One byte past the end of the string.
+        str[8] = 'x';
+
+        TEST_ASSERT(!arena_validate(&arena), "Expected an overwritten redzone.");
+
+        str[8] = (char)ARENA_REDZONE_BYTE;
+
+        TEST_ASSERT(arena_validate(&arena), "Expected intact redzones.");
+
+        destroy_arena(&arena);
+    }
+#endif
+
+    TEST_CASE("Checked: reset releases poisoned memory") {
+
+        arena_t arena = create_arena(1024);
+
+        uint8_t* ptr = (uint8_t*)arena_alloc(&arena, 64);
+        memset(ptr, 0xAB, 64);
+
+        arena_reset(&arena);
+
+        TEST_ASSERT(is_filled(ptr, 64, ARENA_RELEASED_BYTE), "Expected released memory.");
+
+        uint8_t* ptr2 = (uint8_t*)arena_alloc(&arena, 64);
+        memset(ptr2, 0xCD, 64);
+
+        TEST_ASSERT(ptr2 == ptr, "Expected same memory address.");
+        TEST_ASSERT(arena_validate(&arena), "Expected intact redzones.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Checked: restore drops the rewound redzones") {
+
+        arena_t arena = create_arena(1024);
+
+        const arena_mark_t mark = arena_save(&arena);
+
+        uint8_t* ptr = NULL;
+
+        for(int i = 0; i < 16; i++) {
+            uint8_t* block = (uint8_t*)arena_alloc(&arena, 100);
+
+            if(ptr == NULL) {
+                ptr = block;
+            }
+        }
+
+        arena_restore(&arena, mark);
+
+        // A single block over the rewound allocations and their redzones.
+        uint8_t* block = (uint8_t*)arena_alloc(&arena, 400);
+        memset(block, 0, 400);
+
+        TEST_ASSERT(block == ptr, "Expected same memory address.");
+        TEST_ASSERT(arena_validate(&arena), "Expected intact redzones.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Checked: restore only checks the redzones since the mark") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        for(int i = 0; i < 64; i++) {
+            arena_alloc(&arena, 16);
+        }
+
+        for(int i = 0; i < 1000; i++) {
+            const arena_mark_t mark = arena_save(&arena);
+
+            TEST_ASSERT(mark.redzones_count == 64, "Expected 64 redzones, got %zu.", mark.redzones_count);
+
+            arena_alloc(&arena, 32);
+            arena_alloc(&arena, 32);
+            arena_restore(&arena, mark);
+        }
+
+        TEST_ASSERT(arena.redzones->count == 64, "Expected the rewound redzones to be dropped.");
+        TEST_ASSERT(arena_validate(&arena), "Expected intact redzones.");
+
+        destroy_arena(&arena);
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(checked_mode, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}
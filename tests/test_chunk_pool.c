@@ -0,0 +1,349 @@
+#include "test.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int malloc_calls = 0;
+
+static void* counting_malloc(size_t size) {
+    __atomic_fetch_add(&malloc_calls, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+#define ARENA_MALLOC counting_malloc
+#define ARENA_CHUNK_POOL
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#include "../arena.h"
+
+#define THREADS_COUNT 32
+#define ROUNDS_COUNT 200
+#define ALLOCATIONS_PER_ROUND 64
+#define POOLED_CHUNKS_COUNT 4096
+
+typedef struct {
+    arena_chunk_pool_t* pool;
+    uint8_t id;
+    int corrupted;
+    size_t malloc_calls;
+} worker_t;
+
+static void* run_rounds(void* arg) {
+
+    worker_t* const worker = (worker_t*)arg;
+
+    arena_t arena = arena_chunk_pool_create_arena(worker->pool);
+    arena_set_max_retained_size(&arena, worker->pool->chunk_size);
+
+    uint8_t* blocks[ALLOCATIONS_PER_ROUND];
+
+    for(int round = 0; round < ROUNDS_COUNT; round++) {
+        for(int i = 0; i < ALLOCATIONS_PER_ROUND; i++) {
+            blocks[i] = (uint8_t*)arena_alloc(&arena, 256);
+            memset(blocks[i], worker->id, 256);
+        }
+
+        for(int i = 0; i < ALLOCATIONS_PER_ROUND; i++) {
+            if(blocks[i][0] != worker->id || blocks[i][255] != worker->id) {
+                worker->corrupted++;
+            }
+        }
+
+        // Only the first chunk is retained, the others go back to the pool.
+        arena_reset(&arena);
+    }
+
+    destroy_arena(&arena);
+
+    return NULL;
+}
+
+// Every arena takes two chunks from the pool and gives them back.
+static void* recycle_chunks(void* arg) {
+
+    worker_t* const worker = (worker_t*)arg;
+
+    for(int round = 0; round < ROUNDS_COUNT; round++) {
+        arena_t arena = arena_chunk_pool_create_arena(worker->pool);
+
+        for(int i = 0; i < 2; i++) {
+            uint8_t* const block = (uint8_t*)arena_alloc(&arena, 3000);
+            memset(block, worker->id, 3000);
+        }
+
+        worker->malloc_calls += arena_get_stats(&arena).malloc_calls;
+
+        destroy_arena(&arena);
+    }
+
+    return NULL;
+}
+
+TEST_SUITE(arena_chunk_pool) {
+
+    TEST_CASE("Chunk pool: chunks are recycled across arenas") {
+
+        arena_chunk_pool_t pool = create_arena_chunk_pool(1024);
+
+        arena_t arena = arena_chunk_pool_create_arena(&pool);
+        void* first = arena_alloc(&arena, 1000);
+        void* second = arena_alloc(&arena, 1000);
+        destroy_arena(&arena);
+
+        arena_t arena2 = arena_chunk_pool_create_arena(&pool);
+        void* first2 = arena_alloc(&arena2, 1000);
+        void* second2 = arena_alloc(&arena2, 1000);
+
+        TEST_ASSERT(arena_get_stats(&arena2).malloc_calls == 0, "Expected no chunk allocated with malloc.");
+        TEST_ASSERT((first2 == first && second2 == second) || (first2 == second && second2 == first),
+                    "Expected the same chunks.");
+
+        destroy_arena(&arena2);
+        destroy_arena_chunk_pool(&pool);
+    }
+
+    TEST_CASE("Chunk pool: chunks are recycled by size") {
+
+        arena_chunk_pool_t pool = create_arena_chunk_pool(1024);
+
+        arena_t arena = arena_chunk_pool_create_arena(&pool);
+        void* large = arena_alloc(&arena, 4000);
+        destroy_arena(&arena);
+
+        TEST_ASSERT(pool.size == 1024 + 4096, "Expected the two chunks in the pool, got %zu bytes.", pool.size);
+
+        arena_t arena2 = arena_chunk_pool_create_arena(&pool);
+        void* large2 = arena_alloc(&arena2, 3000);
+
+        TEST_ASSERT(large2 == large, "Expected the same chunk.");
+        TEST_ASSERT(arena_get_stats(&arena2).malloc_calls == 0, "Expected no chunk allocated with malloc.");
+
+        destroy_arena(&arena2);
+        destroy_arena_chunk_pool(&pool);
+
+        TEST_ASSERT(pool.size == 0, "Expected an empty pool.");
+    }
+
+    TEST_CASE("Chunk pool: the pool is capped and trimmed") {
+
+        arena_chunk_pool_t pool = create_arena_chunk_pool(1024);
+        arena_chunk_pool_set_max_size(&pool, 2048);
+
+        arena_t arena = arena_chunk_pool_create_arena(&pool);
+
+        for(int i = 0; i < 4; i++) {
+            arena_alloc(&arena, 1000);
+        }
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 4, "Expected 4 chunks.");
+
+        destroy_arena(&arena);
+
+        TEST_ASSERT(pool.size == 2048, "Expected 2048 bytes in the pool, got %zu bytes.", pool.size);
+
+        arena_chunk_pool_trim(&pool, 1024);
+        TEST_ASSERT(pool.size == 1024, "Expected 1024 bytes in the pool, got %zu bytes.", pool.size);
+
+        arena_chunk_pool_trim(&pool, 0);
+        TEST_ASSERT(pool.size == 0, "Expected an empty pool.");
+
+        arena_t arena2 = arena_chunk_pool_create_arena(&pool);
+        TEST_ASSERT(arena_get_stats(&arena2).malloc_calls == 1, "Expected a chunk allocated with malloc.");
+
+        destroy_arena(&arena2);
+        destroy_arena_chunk_pool(&pool);
+    }
+
+    TEST_CASE("Chunk pool: releases and trims don't wait for a stalled pop") {
+
+        arena_chunk_pool_t pool = create_arena_chunk_pool(1024);
+        arena_chunk_pool_set_max_size(&pool, 1024);
+
+        arena_t arena = arena_chunk_pool_create_arena(&pool);
+        arena_t arena2 = arena_chunk_pool_create_arena(&pool);
+
+        // A pop stalled (a preempted thread) for the whole case.
+        __atomic_add_fetch(&pool.poppers, 1, __ATOMIC_SEQ_CST);
+
+        destroy_arena(&arena);
+        destroy_arena(&arena2);
+
+        TEST_ASSERT(pool.size == 1024, "Expected 1024 bytes in the pool, got %zu bytes.", pool.size);
+        TEST_ASSERT(pool.retired != NULL, "Expected the chunk beyond the cap to be retired.");
+
+        arena_chunk_pool_trim(&pool, 0);
+
+        TEST_ASSERT(pool.size == 0, "Expected an empty pool.");
+        TEST_ASSERT(pool.retired != NULL && pool.retired->next != NULL, "Expected the two chunks to be retired.");
+
+        __atomic_sub_fetch(&pool.poppers, 1, __ATOMIC_SEQ_CST);
+
+        // The next pop frees the retired chunks.
+        arena_t arena3 = arena_chunk_pool_create_arena(&pool);
+        TEST_ASSERT(pool.retired == NULL, "Expected the retired chunks to be freed.");
+
+        destroy_arena(&arena3);
+        destroy_arena_chunk_pool(&pool);
+    }
+
+    TEST_CASE("Chunk pool: thread local arenas sharing a pool") {
+
+        arena_chunk_pool_t pool = create_arena_chunk_pool(PAGE_SIZE);
+
+        pthread_t threads[THREADS_COUNT];
+        worker_t workers[THREADS_COUNT];
+
+        const int calls = malloc_calls;
+
+        for(int i = 0; i < THREADS_COUNT; i++) {
+            workers[i].pool = &pool;
+            workers[i].id = (uint8_t)(i + 1);
+            workers[i].corrupted = 0;
+
+            pthread_create(&threads[i], NULL, run_rounds, &workers[i]);
+        }
+
+        int corrupted = 0;
+
+        for(int i = 0; i < THREADS_COUNT; i++) {
+            pthread_join(threads[i], NULL);
+            corrupted += workers[i].corrupted;
+        }
+
+        // Every round needs 4 chunks: without the pool it would be
+        // THREADS_COUNT * ROUNDS_COUNT * 3 malloc calls. With the pool,
+        // only the first rounds (and the races on the pool) need malloc.
+        const int pool_calls = malloc_calls - calls;
+
+        TEST_ASSERT(corrupted == 0, "Found %d corrupted allocations.", corrupted);
+        TEST_ASSERT(pool_calls <= THREADS_COUNT * ROUNDS_COUNT / 4,
+                    "Expected the chunks to be recycled, but got %d malloc calls.", pool_calls);
+
+        destroy_arena_chunk_pool(&pool);
+    }
+
+    TEST_CASE("Chunk pool: a chunk back at the head of a bucket changes its tag") {
+
+        arena_chunk_pool_t pool = create_arena_chunk_pool(1024);
+
+        arena_t arena = arena_chunk_pool_create_arena(&pool);
+        arena_alloc(&arena, 1000);
+        destroy_arena(&arena);
+
+        // A pop delayed after reading this head must not install its stale link.
+        const arena_chunk_pool_bucket_t* const bucket = &pool.buckets[10];
+        const arena_chunk_pool_bucket_t stale_head = *bucket;
+
+        arena_t arena2 = arena_chunk_pool_create_arena(&pool);
+        arena_alloc(&arena2, 1000);
+        destroy_arena(&arena2);
+
+        TEST_ASSERT(stale_head.first != NULL && bucket->first == stale_head.first, "Expected the same first chunk.");
+        TEST_ASSERT(bucket->tag != stale_head.tag, "Expected a new tag.");
+
+        destroy_arena_chunk_pool(&pool);
+    }
+
+    TEST_CASE("Chunk pool: a stalled pop fails once its chunk was popped and pushed back") {
+
+        arena_chunk_pool_t pool = create_arena_chunk_pool(1024);
+        arena_t arenas[3];
+
+        for(int i = 0; i < 3; i++) {
+            arenas[i] = arena_chunk_pool_create_arena(&pool);
+        }
+
+        for(int i = 0; i < 3; i++) {
+            destroy_arena(&arenas[i]);
+        }
+
+        arena_chunk_pool_bucket_t* const bucket = &pool.buckets[10];
+        arena_chunk_t* const z = arena_chunk_pool_pop_bucket(&pool, bucket);
+
+        // A pop reads the head (c) and its link (n), then stalls.
+        arena_chunk_pool_bucket_t stale_head = arena_chunk_pool_read(bucket);
+        arena_chunk_t* const c = stale_head.first;
+        arena_chunk_t* const n = c->next;
+
+        // Meanwhile, the other threads pop c and n, then push z and c back.
+        TEST_ASSERT(arena_chunk_pool_pop_bucket(&pool, bucket) == c, "Expected c.");
+        TEST_ASSERT(arena_chunk_pool_pop_bucket(&pool, bucket) == n, "Expected n.");
+
+        arena_chunk_pool_push(bucket, z);
+        arena_chunk_pool_push(bucket, c);
+
+        // The stalled pop resumes with c at the head again, n (in use) must not become the head.
+        TEST_ASSERT(!arena_chunk_pool_replace(bucket, &stale_head, n), "Expected the stale pop to fail.");
+        TEST_ASSERT(arena_chunk_pool_pop_bucket(&pool, bucket) == c, "Expected c.");
+        TEST_ASSERT(arena_chunk_pool_pop_bucket(&pool, bucket) == z, "Expected z.");
+
+        arena_chunk_pool_push(bucket, z);
+        arena_chunk_pool_push(bucket, n);
+        arena_chunk_pool_push(bucket, c);
+
+        destroy_arena_chunk_pool(&pool);
+        TEST_ASSERT(pool.size == 0, "Expected an empty pool.");
+    }
+
+    TEST_CASE("Chunk pool: concurrent pops from a large pool, past a stalled pop") {
+
+        arena_chunk_pool_t pool = create_arena_chunk_pool(PAGE_SIZE);
+
+        arena_t arena = arena_chunk_pool_create_arena(&pool);
+
+        for(int i = 0; i < POOLED_CHUNKS_COUNT; i++) {
+            arena_alloc(&arena, 3000);
+        }
+
+        destroy_arena(&arena);
+
+        TEST_ASSERT(pool.size == (size_t)POOLED_CHUNKS_COUNT * PAGE_SIZE, "Expected %d chunks in the pool.", 
+                    POOLED_CHUNKS_COUNT);
+
+        pthread_t threads[THREADS_COUNT];
+        worker_t workers[THREADS_COUNT];
+
+        /*
+          A pop stalled forever (a preempted thread) is announced for the whole 
+          run: the pushes and the other pops must not wait for it.
+        */
+        __atomic_add_fetch(&pool.poppers, 1, __ATOMIC_SEQ_CST);
+
+        for(int i = 0; i < THREADS_COUNT; i++) {
+            workers[i].pool = &pool;
+            workers[i].id = (uint8_t)(i + 1);
+            workers[i].malloc_calls = 0;
+
+            pthread_create(&threads[i], NULL, recycle_chunks, &workers[i]);
+        }
+
+        size_t calls = 0;
+
+        for(int i = 0; i < THREADS_COUNT; i++) {
+            pthread_join(threads[i], NULL);
+            calls += workers[i].malloc_calls;
+        }
+
+        __atomic_sub_fetch(&pool.poppers, 1, __ATOMIC_SEQ_CST);
+
+        // The pool never runs out of chunks, a pop must not see an empty bucket.
+        TEST_ASSERT(calls == 0, "Expected no chunk allocated with malloc, got %zu.", calls);
+        TEST_ASSERT(pool.size == (size_t)POOLED_CHUNKS_COUNT * PAGE_SIZE, "Expected every chunk back in the pool.");
+
+        destroy_arena_chunk_pool(&pool);
+        TEST_ASSERT(pool.size == 0, "Expected an empty pool.");
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(arena_chunk_pool, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}
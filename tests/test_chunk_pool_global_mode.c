@@ -0,0 +1,49 @@
+#include "test.h"
+
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#define ARENA_CHUNK_POOL_GLOBAL
+#include "../arena.h"
+
+TEST_SUITE(chunk_pool_global_mode) {
+
+    TEST_CASE("Global chunk pool: arenas reuse the chunks of the destroyed ones") {
+
+        arena_chunk_pool_t* const pool = arena_chunk_pool_get_global();
+
+        arena_t arena = create_arena(1000);
+        void* first = arena_alloc(&arena, 1000);
+        void* second = arena_alloc(&arena, 1000);
+
+        TEST_ASSERT(arena_get_stats(&arena).malloc_calls == 2, "Expected two chunks allocated with malloc.");
+
+        destroy_arena(&arena);
+
+        TEST_ASSERT(pool->size == 2048, "Expected 2048 bytes in the pool, got %zu bytes.", pool->size);
+
+        arena_t arena2 = create_arena(1000);
+        void* first2 = arena_alloc(&arena2, 1000);
+        void* second2 = arena_alloc(&arena2, 1000);
+
+        TEST_ASSERT(arena_get_stats(&arena2).malloc_calls == 0, "Expected no chunk allocated with malloc.");
+        TEST_ASSERT((first2 == first && second2 == second) || (first2 == second && second2 == first),
+                    "Expected the same chunks.");
+
+        destroy_arena(&arena2);
+
+        arena_chunk_pool_trim(pool, 0);
+        TEST_ASSERT(pool->size == 0, "Expected an empty pool.");
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(chunk_pool_global_mode, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "test.h"
+
+// A restrict macro defined before the include is kept.
+#define restrict __restrict__
+#include "../arena.hpp"
+
+#ifndef restrict
+#error "Expected the restrict macro to be kept."
+#endif
+
+#undef restrict
+
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+TEST_SUITE(cpp_adapters) {
+
+    TEST_CASE("C++: pmr containers allocate from the arena") {
+
+        arena_owner owner(PAGE_SIZE);
+        arena_memory_resource resource(owner.get());
+
+        std::pmr::vector<int> integers(&resource);
+        std::pmr::unordered_map<int, std::pmr::string> names(&resource);
+
+        for(int i = 0; i < 1000; i++) {
+            integers.push_back(i);
+            names.emplace(i, "a name long enough to skip the small string optimization");
+        }
+
+        int sum = 0;
+
+        for(int integer : integers) {
+            sum += integer;
+        }
+
+        TEST_ASSERT(sum == 999 * 1000 / 2, "Expected the sum of the integers.");
+        TEST_ASSERT(names.size() == 1000, "Expected 1000 names.");
+        TEST_ASSERT(names.at(500).get_allocator().resource() == &resource, "Expected the arena resource.");
+        TEST_ASSERT(arena_get_stats(owner.get()).requested > 1000 * sizeof(int), "Expected the arena to be used.");
+    }
+
+    TEST_CASE("C++: deallocating the last block rewinds the arena") {
+
+        arena_owner owner(1024);
+        arena_memory_resource resource(owner.get());
+
+        void* first = resource.allocate(64, 16);
+        void* second = resource.allocate(64, 16);
+
+        resource.deallocate(first, 64, 16);
+        TEST_ASSERT(arena_get_current_used_space(owner.get()) == 128, "Expected the used space to be unchanged.");
+
+        resource.deallocate(second, 64, 16);
+        TEST_ASSERT(arena_get_current_used_space(owner.get()) == 64, "Expected 64 bytes used.");
+
+        TEST_ASSERT(resource.allocate(64, 16) == second, "Expected same memory address.");
+
+        arena_memory_resource other(owner.get());
+        TEST_ASSERT(resource.is_equal(resource) && !resource.is_equal(other), "Expected identity equality.");
+    }
+
+    TEST_CASE("C++: only the last buffer of a vector is given back") {
+
+        arena_owner owner(PAGE_SIZE);
+        arena_allocator<int> allocator(owner.get());
+
+        std::vector<int, arena_allocator<int>> integers(allocator);
+        size_t allocated = 0;
+
+        for(int i = 0; i < 256; i++) {
+            const size_t capacity = integers.capacity();
+            integers.push_back(i);
+
+            if(integers.capacity() != capacity) {
+                allocated += integers.capacity() * sizeof(int);
+            }
+        }
+
+        TEST_ASSERT(integers.get_allocator() == allocator, "Expected equal allocators.");
+        TEST_ASSERT(integers[255] == 255, "Expected the last integer.");
+
+        // The new buffer is allocated before the old one is freed, growing never rewinds the arena.
+        const size_t used = arena_get_stats(owner.get()).used;
+        TEST_ASSERT(used == allocated, "Expected %zu bytes used, got %zu bytes.", allocated, used);
+
+        // The last buffer is at the tail of the arena, freeing it rewinds the arena.
+        const size_t last_size = integers.capacity() * sizeof(int);
+
+        integers.clear();
+        integers.shrink_to_fit();
+
+        TEST_ASSERT(arena_get_stats(owner.get()).used == used - last_size, "Expected the last buffer to be given back.");
+
+        arena_allocator<double> rebound(allocator);
+        TEST_ASSERT(rebound.get_arena() == owner.get(), "Expected the same arena.");
+    }
+
+    TEST_CASE("C++: the owner resets and destroys the arena") {
+
+        arena_owner owner(1024);
+
+        char* str = arena_strdup(owner.get(), "owned");
+        TEST_ASSERT(strcmp(str, "owned") == 0, "Expected same content.");
+
+        owner.reset();
+
+        TEST_ASSERT(arena_get_current_used_space(owner.get()) == 0, "Expected an empty arena.");
+        TEST_ASSERT(arena_alloc(owner.get(), 6) == str, "Expected same memory address.");
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(cpp_adapters, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}
@@ -42,6 +42,105 @@ TEST_SUITE(reduce_fragmentation_mode) {
 
         destroy_arena(&arena);
     }
+
+    TEST_CASE("Reduce fragmentation: holes are searched up to the current chunk") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        const int big_array_size = PAGE_SIZE;
+        const int small_array_size = PAGE_SIZE / 2;
+
+        arena_alloc(&arena, big_array_size);
+        arena_alloc(&arena, big_array_size);
+        arena_alloc(&arena, big_array_size);
+
+        arena_reset(&arena);
+
+        int* array = (int*)arena_alloc(&arena, small_array_size);
+        int* array1 = (int*)arena_alloc(&arena, big_array_size);
+        int* array2 = (int*)arena_alloc(&arena, small_array_size);
+
+        TEST_ASSERT(&array[small_array_size / sizeof(int)] == array2, "Expected same memory address.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 1) == (size_t)big_array_size, 
+                    "Expected the retained chunk to be reused.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 2) == 0, "Expected an unused retained chunk.");
+
+        (void) array1;
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 3, "Expected 3 chunks.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Reduce fragmentation: full chunks leave the free space index") {
+
+        arena_t arena = create_arena(1024);
+
+        for(int i = 0; i < 1000; i++) {
+            arena_alloc(&arena, 1016);
+        }
+
+        TEST_ASSERT(arena.free_index->bitmap == 0, "Expected an empty free space index.");
+
+        // The 8 bytes left in every chunk are not searched anymore.
+        arena_alloc(&arena, 8);
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 1001, "Expected 1001 chunks.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Reduce fragmentation: restored chunks leave the free space index") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        arena_alloc(&arena, PAGE_SIZE / 2);
+        arena_mark_t mark = arena_save(&arena);
+
+        arena_alloc(&arena, PAGE_SIZE);
+        arena_alloc(&arena, PAGE_SIZE / 4);
+
+        arena_restore(&arena, mark);
+
+        // The hole left in the first chunk is found again, the rewound chunk is a spare.
+        uint8_t* ptr = (uint8_t*)arena_alloc(&arena, PAGE_SIZE / 4);
+
+        TEST_ASSERT(ptr == arena.begin->data + PAGE_SIZE / 2, "Expected same memory address.");
+        TEST_ASSERT(arena_get_used_space_of(&arena, 1) == 0, "Expected an unused retained chunk.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Reduce fragmentation: restore keeps the holes filled after the mark") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        arena_alloc(&arena, PAGE_SIZE / 2);
+        arena_alloc(&arena, PAGE_SIZE);
+
+        arena_mark_t mark = arena_save(&arena);
+
+        uint8_t* hole = (uint8_t*)arena_alloc(&arena, PAGE_SIZE / 4);
+        TEST_ASSERT(hole == arena.begin->data + PAGE_SIZE / 2, "Expected the hole of the first chunk.");
+
+        memset(hole, 0xCD, PAGE_SIZE / 4);
+        arena_restore(&arena, mark);
+
+        // The chunks older than the mark aren't rewound, the block stays allocated.
+        TEST_ASSERT(arena_get_used_space_of(&arena, 0) == PAGE_SIZE / 2 + PAGE_SIZE / 4, 
+                    "Expected the hole allocation to be kept.");
+        TEST_ASSERT(arena_get_stats(&arena).used == PAGE_SIZE + PAGE_SIZE / 2 + PAGE_SIZE / 4, 
+                    "Expected the hole allocation to be counted.");
+        TEST_ASSERT(hole[PAGE_SIZE / 4 - 1] == 0xCD, "Expected the same content.");
+
+        uint8_t* ptr = (uint8_t*)arena_alloc(&arena, PAGE_SIZE / 4);
+        TEST_ASSERT(ptr == hole + PAGE_SIZE / 4, "Expected the rest of the hole.");
+
+        // Only a reset releases it.
+        arena_reset(&arena);
+        TEST_ASSERT(arena_get_stats(&arena).used == 0, "Expected 0 bytes used.");
+
+        destroy_arena(&arena);
+    }
 }
 
 int main(int argc, char** argv, test_context_t* context) {
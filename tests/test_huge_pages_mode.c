@@ -0,0 +1,52 @@
+#define _DEFAULT_SOURCE
+
+#include "test.h"
+
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#define ARENA_HUGE_PAGES
+#include "../arena.h"
+
+#include <string.h>
+
+TEST_SUITE(huge_pages_mode) {
+
+    TEST_CASE("Huge pages: chunks are aligned to a huge page") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        TEST_ASSERT((uintptr_t)arena.begin % HUGE_PAGE_SIZE == 0, "Expected an aligned chunk.");
+        TEST_ASSERT(arena_get_current_available_space(&arena) == HUGE_PAGE_SIZE - sizeof(arena_chunk_t),
+                    "Expected the chunk size to be rounded to a huge page.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Huge pages: oversized chunks are rounded to huge pages") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        const size_t big_size = 3 * HUGE_PAGE_SIZE / 2;
+        uint8_t* big = (uint8_t*)arena_alloc(&arena, big_size);
+        memset(big, 0xAB, big_size);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 2, "Expected 2 chunks.");
+        TEST_ASSERT((uintptr_t)arena.begin->next % HUGE_PAGE_SIZE == 0, "Expected an aligned chunk.");
+        TEST_ASSERT(arena.begin->next->size + sizeof(arena_chunk_t) == 2 * HUGE_PAGE_SIZE,
+                    "Expected the chunk size to be rounded to huge pages.");
+
+        destroy_arena(&arena);
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(huge_pages_mode, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+#define _DEFAULT_SOURCE
+
+#include "test.h"
+
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#define ARENA_THREAD_SAFE
+#define ARENA_PREFAULT_THREAD
+#include "../arena.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#define ROLLOVERS_COUNT 8
+
+// Waits up to a second for the background thread to refill the spare chunk.
+static arena_chunk_t* wait_for_spare(arena_t* arena) {
+
+    for(int i = 0; i < 1000; i++) {
+        arena_chunk_t* const spare = __atomic_load_n(&arena->spare, __ATOMIC_ACQUIRE);
+
+        if(spare != NULL) {
+            return spare;
+        }
+
+        usleep(1000);
+    }
+
+    return NULL;
+}
+
+TEST_SUITE(prefault_mode) {
+
+    TEST_CASE("Prefault: the spare chunk is used on rollover") {
+
+        arena_t arena = create_arena(1024);
+
+        arena_prefault(&arena);
+        arena_chunk_t* spare = arena.spare;
+
+        arena_prefault(&arena);
+
+        TEST_ASSERT(spare != NULL && spare->size == 1024, "Expected a spare chunk.");
+        TEST_ASSERT(arena.spare == spare, "Expected a single spare chunk.");
+
+        arena_alloc(&arena, 1000);
+        uint8_t* ptr = (uint8_t*)arena_alloc(&arena, 1000);
+        memset(ptr, 0xAB, 1000);
+
+        TEST_ASSERT(arena_get_chunk(&arena, 1) == spare, "Expected the spare chunk.");
+        TEST_ASSERT(arena.spare == NULL, "Expected no spare chunk.");
+        TEST_ASSERT(arena_get_stats(&arena).malloc_calls == 2, "Expected 2 chunks allocated with malloc.");
+
+        // Without ARENA_THREAD_SAFE_STATS the used space is summed from the chunks.
+        TEST_ASSERT(arena_get_stats(&arena).used == 2000, "Expected 2000 bytes used.");
+        TEST_ASSERT(arena_get_stats(&arena).requested == 0, "Expected no allocation counters.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Prefault: a dedicated chunk doesn't take the spare") {
+
+        arena_t arena = create_arena(1024);
+
+        arena_prefault(&arena);
+        arena_chunk_t* spare = arena.spare;
+
+        uint8_t* ptr = (uint8_t*)arena_alloc(&arena, 4000);
+        memset(ptr, 0xAB, 4000);
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 2, "Expected 2 chunks.");
+        TEST_ASSERT(arena.spare == spare, "Expected the spare chunk to be kept.");
+
+        // The spare chunk is freed with the arena.
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Prefault: an undersized spare chunk is replaced when the chunks grow") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        arena_prefault(&arena);
+        arena_set_max_chunk_size(&arena, 1 << 16);
+
+        int rollovers = 0;
+        int refilled = 0;
+
+        for(int i = 0; i < 200; i++) {
+            const arena_chunk_t* const end = arena.end;
+            const arena_chunk_t* const spare = arena.spare;
+
+            arena_alloc(&arena, 4000);
+
+            if(arena.end != end) {
+                rollovers++;
+                refilled += arena.end == spare;
+            }
+
+            arena_prefault(&arena);
+        }
+
+        TEST_ASSERT(arena_get_chunk(&arena, 4)->size == 1 << 16, "Expected the chunks to grow.");
+        TEST_ASSERT(refilled == rollovers, "Expected %d rollovers on a spare chunk, got %d.", rollovers, refilled);
+        TEST_ASSERT(arena.spare != NULL && arena.spare->size == 1 << 16, "Expected a spare of the new size.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Prefault: the background thread refills the spare chunk") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_start_prefault_thread(&arena);
+
+        int refilled = 0;
+
+        for(int i = 0; i < ROLLOVERS_COUNT; i++) {
+            const int chunks_count = arena_get_chunks_count(&arena);
+
+            // Past the threshold, but the end chunk isn't full yet.
+            while(arena_get_current_used_space(&arena) < PAGE_SIZE - 512) {
+                arena_alloc(&arena, 256);
+            }
+
+            arena_chunk_t* const spare = wait_for_spare(&arena);
+
+            while(arena_get_chunks_count(&arena) == chunks_count) {
+                arena_alloc(&arena, 256);
+            }
+
+            if(spare != NULL && arena.end == spare) {
+                refilled++;
+            }
+        }
+
+        TEST_ASSERT(refilled == ROLLOVERS_COUNT, "Expected %d rollovers on a spare chunk, got %d.",
+                    ROLLOVERS_COUNT, refilled);
+
+        arena_stop_prefault_thread(&arena);
+        arena_stop_prefault_thread(&arena);
+
+        destroy_arena(&arena);
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(prefault_mode, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}
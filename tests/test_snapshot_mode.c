@@ -0,0 +1,218 @@
+#define _DEFAULT_SOURCE
+
+#include "test.h"
+
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#define ARENA_SNAPSHOT
+#include "../arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NODES_COUNT 1000
+
+typedef struct {
+    int key;
+    arena_rel_ptr_t name;
+    arena_rel_ptr_t left;
+    arena_rel_ptr_t right;
+} node_t;
+
+static void insert_node(arena_t* arena, node_t* root, node_t* node) {
+
+    node_t* it = root;
+
+    while(1) {
+        arena_rel_ptr_t* const child = (node->key < it->key) ? &it->left : &it->right;
+
+        if(child->offset == 0) {
+            *child = arena_to_rel_ptr(arena, node);
+            return;
+        }
+
+        it = (node_t*)arena_from_rel_ptr(arena, *child);
+    }
+}
+
+static const node_t* find_node(const arena_snapshot_t* snapshot, int key) {
+
+    const node_t* it = (const node_t*)arena_snapshot_root(snapshot);
+
+    while(it != NULL && it->key != key) {
+        it = (const node_t*)arena_snapshot_ptr(snapshot, (key < it->key) ? it->left : it->right);
+    }
+
+    return it;
+}
+
+TEST_SUITE(snapshot_mode) {
+
+    TEST_CASE("Snapshot: relative pointers round trip") {
+
+        arena_t arena = create_arena(256);
+
+        void* ptrs[64];
+
+        for(int i = 0; i < 64; i++) {
+            ptrs[i] = arena_alloc(&arena, 24);
+        }
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) > 1, "Expected more than one chunk.");
+        TEST_ASSERT(arena_to_rel_ptr(&arena, NULL).offset == 0, "Expected a NULL relative pointer.");
+        TEST_ASSERT(arena_from_rel_ptr(&arena, arena_to_rel_ptr(&arena, NULL)) == NULL, "Expected NULL.");
+
+        int mismatches = 0;
+
+        for(int i = 0; i < 64; i++) {
+            if(arena_from_rel_ptr(&arena, arena_to_rel_ptr(&arena, ptrs[i])) != ptrs[i]) {
+                mismatches++;
+            }
+        }
+
+        TEST_ASSERT(mismatches == 0, "Found %d mismatching pointers.", mismatches);
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Snapshot: a tree is mapped back read-only") {
+
+        char path[] = "/tmp/arena_snapshot_XXXXXX";
+        close(mkstemp(path));
+
+        arena_t arena = create_arena(1024);
+
+        node_t* root = NULL;
+        unsigned int seed = 42;
+
+        for(int i = 0; i < NODES_COUNT; i++) {
+            seed = seed * 1103515245 + 12345;
+
+            node_t* const node = ARENA_NEW(&arena, node_t, 1);
+            memset(node, 0, sizeof(node_t));
+            node->key = (int)(seed >> 8);
+
+            char name[32];
+            sprintf(name, "node%d", node->key);
+            node->name = arena_to_rel_ptr(&arena, arena_strdup(&arena, name));
+
+            if(root == NULL) {
+                root = node;
+            } else {
+                insert_node(&arena, root, node);
+            }
+        }
+
+        // An over-aligned allocation keeps its alignment in the image.
+        double* const aligned = (double*)arena_alloc_aligned(&arena, sizeof(double), 256);
+        *aligned = 3.5;
+        const arena_rel_ptr_t aligned_ptr = arena_to_rel_ptr(&arena, aligned);
+
+        TEST_ASSERT(arena_write_snapshot(&arena, root, path), "Expected the snapshot to be written.");
+
+        destroy_arena(&arena);
+
+        arena_snapshot_t snapshot = arena_map_snapshot(path);
+        TEST_ASSERT(snapshot.data != NULL, "Expected the snapshot to be mapped.");
+
+        int missing = 0;
+        seed = 42;
+
+        for(int i = 0; i < NODES_COUNT; i++) {
+            seed = seed * 1103515245 + 12345;
+
+            const int key = (int)(seed >> 8);
+            const node_t* const node = find_node(&snapshot, key);
+
+            char name[32];
+            sprintf(name, "node%d", key);
+
+            if(node == NULL || strcmp((const char*)arena_snapshot_ptr(&snapshot, node->name), name) != 0) {
+                missing++;
+            }
+        }
+
+        const double* const mapped_aligned = (const double*)arena_snapshot_ptr(&snapshot, aligned_ptr);
+
+        TEST_ASSERT(missing == 0, "Found %d missing nodes.", missing);
+        TEST_ASSERT(((uintptr_t)mapped_aligned & 255) == 0, "Expected a 256 bytes aligned pointer.");
+        TEST_ASSERT(*mapped_aligned == 3.5, "Expected the same value.");
+
+        arena_unmap_snapshot(&snapshot);
+        unlink(path);
+    }
+
+    TEST_CASE("Snapshot: a mapped snapshot survives a rewrite") {
+
+        char path[] = "/tmp/arena_snapshot_XXXXXX";
+        close(mkstemp(path));
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        char* last = NULL;
+
+        for(int i = 0; i < 16; i++) {
+            last = (char*)arena_alloc(&arena, PAGE_SIZE / 2);
+            memset(last, 'a', PAGE_SIZE / 2);
+        }
+
+        last[PAGE_SIZE / 2 - 1] = '\0';
+
+        TEST_ASSERT(arena_write_snapshot(&arena, last, path), "Expected the snapshot to be written.");
+        destroy_arena(&arena);
+
+        arena_snapshot_t snapshot = arena_map_snapshot(path);
+        TEST_ASSERT(snapshot.data != NULL, "Expected the snapshot to be mapped.");
+
+        // A smaller image over the mapped one.
+        arena = create_arena(256);
+        char* const str = arena_strdup(&arena, "small");
+
+        TEST_ASSERT(arena_write_snapshot(&arena, str, path), "Expected the snapshot to be rewritten.");
+        destroy_arena(&arena);
+
+        const char* const mapped_last = (const char*)arena_snapshot_root(&snapshot);
+        TEST_ASSERT(mapped_last[0] == 'a' && strlen(mapped_last) == PAGE_SIZE / 2 - 1,
+                    "Expected the previous image to be unchanged.");
+
+        arena_unmap_snapshot(&snapshot);
+
+        snapshot = arena_map_snapshot(path);
+        TEST_ASSERT(snapshot.data != NULL, "Expected the new snapshot to be mapped.");
+        TEST_ASSERT(strcmp((const char*)arena_snapshot_root(&snapshot), "small") == 0, "Expected the new root.");
+
+        arena_unmap_snapshot(&snapshot);
+        unlink(path);
+    }
+
+    TEST_CASE("Snapshot: invalid files are rejected") {
+
+        char path[] = "/tmp/arena_snapshot_XXXXXX";
+        const int fd = mkstemp(path);
+
+        const char garbage[64] = "not a snapshot";
+        TEST_ASSERT(write(fd, garbage, sizeof(garbage)) == sizeof(garbage), "Expected the file to be written.");
+        close(fd);
+
+        arena_snapshot_t snapshot = arena_map_snapshot(path);
+        TEST_ASSERT(snapshot.data == NULL, "Expected an invalid snapshot.");
+
+        unlink(path);
+
+        snapshot = arena_map_snapshot(path);
+        TEST_ASSERT(snapshot.data == NULL, "Expected a missing snapshot.");
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(snapshot_mode, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "test.h"
+
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#define ARENA_THREAD_SAFE
+#define ARENA_THREAD_SAFE_STATS
+#include "../arena.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THREADS_COUNT 8
+#define ALLOCATIONS_PER_THREAD 20000
+
+typedef struct {
+    uint8_t* ptr;
+    size_t size;
+} allocation_t;
+
+typedef struct {
+    arena_t* arena;
+    allocation_t* allocations;
+    uint8_t id;
+} worker_t;
+
+static void* allocate_blocks(void* arg) {
+
+    worker_t* const worker = (worker_t*)arg;
+    unsigned int seed = worker->id;
+
+    for(int i = 0; i < ALLOCATIONS_PER_THREAD; i++) {
+        seed = seed * 1103515245 + 12345;
+
+        const size_t size = 1 + (seed >> 16) % 64;
+        const size_t alignment = (size_t)1 << ((seed >> 8) % 6);
+
+        uint8_t* ptr = (uint8_t*)arena_alloc_aligned(worker->arena, size, alignment);
+        memset(ptr, worker->id, size);
+
+        worker->allocations[i].ptr = ptr;
+        worker->allocations[i].size = size;
+    }
+
+    return NULL;
+}
+
+static int compare_allocations(const void* a, const void* b) {
+    const uintptr_t first = (uintptr_t)((const allocation_t*)a)->ptr;
+    const uintptr_t second = (uintptr_t)((const allocation_t*)b)->ptr;
+
+    return (first > second) - (first < second);
+}
+
+TEST_SUITE(thread_safe_mode) {
+
+    TEST_CASE("Thread safe: concurrent allocations don't overlap") {
+
+        // Small chunks, so the threads race on the chunk installation too.
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        pthread_t threads[THREADS_COUNT];
+        worker_t workers[THREADS_COUNT];
+
+        allocation_t* const allocations =
+            (allocation_t*)malloc(sizeof(allocation_t) * THREADS_COUNT * ALLOCATIONS_PER_THREAD);
+
+        for(int i = 0; i < THREADS_COUNT; i++) {
+            workers[i].arena = &arena;
+            workers[i].allocations = allocations + i * ALLOCATIONS_PER_THREAD;
+            workers[i].id = (uint8_t)(i + 1);
+
+            pthread_create(&threads[i], NULL, allocate_blocks, &workers[i]);
+        }
+
+        for(int i = 0; i < THREADS_COUNT; i++) {
+            pthread_join(threads[i], NULL);
+        }
+
+        int corrupted = 0;
+        size_t requested = 0;
+
+        for(int i = 0; i < THREADS_COUNT; i++) {
+            for(int j = 0; j < ALLOCATIONS_PER_THREAD; j++) {
+                const allocation_t* allocation = &workers[i].allocations[j];
+                requested += allocation->size;
+
+                for(size_t k = 0; k < allocation->size; k++) {
+                    if(allocation->ptr[k] != workers[i].id) {
+                        corrupted++;
+                        break;
+                    }
+                }
+            }
+        }
+
+        const int allocations_count = THREADS_COUNT * ALLOCATIONS_PER_THREAD;
+        qsort(allocations, allocations_count, sizeof(allocation_t), compare_allocations);
+
+        int overlapping = 0;
+
+        for(int i = 1; i < allocations_count; i++) {
+            if(allocations[i - 1].ptr + allocations[i - 1].size > allocations[i].ptr) {
+                overlapping++;
+            }
+        }
+
+        free(allocations);
+
+        TEST_ASSERT(corrupted == 0, "Found %d corrupted allocations.", corrupted);
+        TEST_ASSERT(overlapping == 0, "Found %d overlapping allocations.", overlapping);
+        TEST_ASSERT(arena_get_chunks_count(&arena) > 1, "Expected more than one chunk.");
+
+        const arena_stats_t stats = arena_get_stats(&arena);
+
+        TEST_ASSERT(stats.requested == requested, "Expected %zu bytes requested.", requested);
+        TEST_ASSERT(stats.chunks_count == (size_t)arena_get_chunks_count(&arena), "Expected the same chunks count.");
+
+        // The chunks installed concurrently are in the directory, in the order of the list.
+        size_t index = 0;
+        int mismatches = 0;
+
+        for(const arena_chunk_t* it = arena.begin; it != NULL; it = it->next) {
+            mismatches += arena_get_chunk(&arena, index++) != it;
+        }
+
+        TEST_ASSERT(mismatches == 0 && index == stats.chunks_count, "Expected the directory to mirror the chunks list.");
+        TEST_ASSERT(arena_get_chunk(&arena, index) == NULL, "Expected NULL past the last chunk.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Thread safe: a stale end moves forward instead of inserting a chunk") {
+
+        arena_t arena = create_arena(256);
+        arena_chunk_t* const first = arena.end;
+
+        // The end rolls over twice past the chunk a slow thread still sees.
+        for(int i = 0; i < 3; i++) {
+            arena_alloc(&arena, 200);
+        }
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 3, "Expected 3 chunks.");
+
+        arena_chunk_t* const chunk = arena_push_chunk(&arena, first, 16, 16);
+
+        TEST_ASSERT(chunk == arena.end, "Expected the current end.");
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 3, "Expected no new chunk.");
+        TEST_ASSERT(first->next->next == arena.end && arena.end->next == NULL, "Expected the same chunks list.");
+
+        destroy_arena(&arena);
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(thread_safe_mode, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}
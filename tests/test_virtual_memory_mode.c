@@ -0,0 +1,127 @@
+#define _DEFAULT_SOURCE
+
+#include "test.h"
+
+#define ARENA_DEBUG_MODE
+#define ARENA_IMPLEMENTATION
+#define ARENA_VIRTUAL_MEMORY
+#include "../arena.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#define MEGABYTE (1 << 20)
+
+static int is_resident(const void* ptr) {
+    unsigned char vector = 0;
+    const uintptr_t page = (uintptr_t)ptr & ~(uintptr_t)(PAGE_SIZE - 1);
+
+    mincore((void*)page, PAGE_SIZE, &vector);
+
+    return vector & 1;
+}
+
+TEST_SUITE(virtual_memory_mode) {
+
+    TEST_CASE("Virtual memory: allocations are contiguous") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        uint8_t* first = (uint8_t*)arena_alloc(&arena, MEGABYTE);
+        uint8_t* previous = first;
+
+        for(int i = 1; i < 64; i++) {
+            uint8_t* ptr = (uint8_t*)arena_alloc(&arena, MEGABYTE);
+            memset(ptr, 0xAB, MEGABYTE);
+
+            TEST_ASSERT(ptr == previous + MEGABYTE, "Expected contiguous allocations.");
+            previous = ptr;
+        }
+
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 1, "Expected one chunk.");
+        TEST_ASSERT(arena_get_current_used_space(&arena) == 64 * MEGABYTE,
+                    "Expected %d bytes used.", 64 * MEGABYTE);
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Virtual memory: realloc at the tail never moves") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        arena_alloc(&arena, 100);
+
+        size_t size = PAGE_SIZE;
+        uint8_t* buffer = (uint8_t*)arena_alloc(&arena, size);
+        uint8_t* const original_buffer = buffer;
+
+        while(size < 128 * MEGABYTE) {
+            buffer = (uint8_t*)arena_realloc(&arena, buffer, size, size * 2);
+            buffer[size * 2 - 1] = 0xAB;
+            size *= 2;
+        }
+
+        TEST_ASSERT(buffer == original_buffer, "Expected same memory address.");
+        TEST_ASSERT(arena_get_chunks_count(&arena) == 1, "Expected one chunk.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Virtual memory: reset releases the pages beyond the high-water mark") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+        arena_set_max_retained_size(&arena, MEGABYTE);
+
+        uint8_t* buffer = (uint8_t*)arena_alloc(&arena, 16 * MEGABYTE);
+        memset(buffer, 0xAB, 16 * MEGABYTE);
+
+        TEST_ASSERT(is_resident(buffer + 8 * MEGABYTE), "Expected a resident page.");
+
+        arena_reset(&arena);
+
+        TEST_ASSERT(is_resident(buffer), "Expected a retained page.");
+        TEST_ASSERT(!is_resident(buffer + 8 * MEGABYTE), "Expected a released page.");
+        TEST_ASSERT(arena.begin->dirty <= MEGABYTE + PAGE_SIZE, "Expected the released pages to be known zero.");
+
+        uint8_t* buffer2 = (uint8_t*)arena_alloc(&arena, 16 * MEGABYTE);
+
+        TEST_ASSERT(buffer2 == buffer, "Expected same memory address.");
+        TEST_ASSERT(buffer2[0] == 0xAB, "Expected the retained content.");
+        TEST_ASSERT(buffer2[8 * MEGABYTE] == 0, "Expected a zero filled page.");
+
+        destroy_arena(&arena);
+    }
+
+    TEST_CASE("Virtual memory: calloc skips the fresh pages") {
+
+        arena_t arena = create_arena(PAGE_SIZE);
+
+        TEST_ASSERT(arena.begin->dirty == 0, "Expected a known zero chunk.");
+
+        uint8_t* buffer = (uint8_t*)arena_alloc(&arena, MEGABYTE);
+        memset(buffer, 0xAB, MEGABYTE);
+
+        arena_reset(&arena);
+
+        // Only the first megabyte is cleared, the other pages have never been touched.
+        uint8_t* buffer2 = (uint8_t*)arena_calloc(&arena, 1, 4 * MEGABYTE);
+
+        TEST_ASSERT(buffer2 == buffer, "Expected same memory address.");
+        TEST_ASSERT(buffer2[0] == 0 && buffer2[MEGABYTE - 1] == 0, "Expected a cleared block.");
+        TEST_ASSERT(!is_resident(buffer2 + 2 * MEGABYTE), "Expected an untouched page.");
+
+        destroy_arena(&arena);
+    }
+}
+
+int main(int argc, char** argv, test_context_t* context) {
+
+    (void) argc;
+    (void) argv;
+
+    RUN_SUITE(virtual_memory_mode, context);
+
+    PRINT_WRAP_UP(context);
+
+    return 0;
+}